@@ -0,0 +1,272 @@
+/*
+* Headless benchmark of every module registered by the plugin. Modules are created from their Model and their process()
+* called directly, without the Rack engine or any widgets, with synthetic clocks, gates and polyphonic CV on every input
+* at 1, 4, 8 and 16 channels. Shared DSP the modules are built on follows, with channels giving the lanes run at once.
+*
+* Results are written to stdout as CSV: module, channels, mean ns/sample, p99 ns/sample (over blocks of BLOCK_SIZE
+* samples) and the number of heap allocations made by process() during the run.
+*
+* Build and run with `make bench`. Arguments are the number of samples per case and an optional module slug filter,
+* e.g. `make bench BENCH_ARGS="480000 Chord"`.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "rack.hpp"
+
+#include "../src/AHCommon.hpp"
+
+using namespace rack;
+
+static const float SAMPLE_RATE = 48000.0f;
+static const int BLOCK_SIZE = 256;
+static const int WARMUP_SAMPLES = 48000;
+static const int CHANNELS[] = {1, 4, 8, 16};
+
+// Count every allocation made while process() is running
+static bool countAllocations = false;
+static long allocations = 0;
+
+void *operator new(std::size_t size) {
+	if (countAllocations) {
+		allocations++;
+	}
+	void *p = std::malloc(size ? size : 1);
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void *operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept {
+	std::free(p);
+}
+
+/*
+* Inputs cycle through clock, CV and gate by port index, so that each module sees all three whatever its port layout.
+* Channels are offset in time so that polyphonic inputs do not move in lock-step.
+*/
+static void stimulate(Module *module, int nChannels, int64_t frame) {
+	for (size_t i = 0; i < module->inputs.size(); i++) {
+		float *v = module->inputs[i].voltages;
+		for (int c = 0; c < nChannels; c++) {
+			int64_t t = frame + c * 61;
+			switch (i % 3) {
+				case 0:	v[c] = (t % (480 * (1 + i % 4))) < 48 ? 10.0f : 0.0f; break;	// 100Hz to 25Hz clock, 1ms pulse
+				case 1:	v[c] = (t % 4800) / 480.0f - 5.0f; break;						// 10Hz ramp, -5V to 5V
+				default: v[c] = (t % 9600) < 4800 ? 10.0f : 0.0f;						// 5Hz gate
+			}
+		}
+	}
+}
+
+struct Result {
+	double nsPerSample;
+	double p99NsPerSample;
+	long allocations;
+};
+
+static double elapsedNs(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Mean and p99 of the per-block timings, less the cost of generating the inputs
+static Result summarise(std::vector<double> &blockNs, double stimulusNs) {
+
+	double total = 0.0;
+	for (double ns : blockNs) {
+		total += ns;
+	}
+	std::sort(blockNs.begin(), blockNs.end());
+
+	Result result;
+	result.nsPerSample = std::max(0.0, total / blockNs.size() - stimulusNs);
+	result.p99NsPerSample = std::max(0.0, blockNs[(size_t)(0.99 * (blockNs.size() - 1))] - stimulusNs);
+	result.allocations = allocations;
+	return result;
+
+}
+
+static Result measure(Model *model, int nChannels, long nSamples) {
+
+	Module *module = model->createModule();
+
+	// Fix the random seed so that runs are repeatable
+	ah::core::AHModule *ahModule = dynamic_cast<ah::core::AHModule*>(module);
+	if (ahModule) {
+		ahModule->seed = 1;
+		ahModule->setFixedSeed(true);
+	}
+
+	// Outputs with no channels are disconnected, and setChannels() would leave them that way
+	for (engine::Output &output : module->outputs) {
+		output.channels = 1;
+	}
+	for (engine::Input &input : module->inputs) {
+		input.channels = nChannels;
+	}
+
+	Module::ProcessArgs args;
+	args.sampleRate = SAMPLE_RATE;
+	args.sampleTime = 1.0f / SAMPLE_RATE;
+	args.frame = 0;
+
+	for (int i = 0; i < WARMUP_SAMPLES; i++) {
+		stimulate(module, nChannels, args.frame);
+		module->process(args);
+		args.frame++;
+	}
+
+	long nBlocks = std::max(1L, nSamples / BLOCK_SIZE);
+	std::vector<double> blockNs;
+	blockNs.reserve(nBlocks);
+
+	// Cost of generating the inputs alone, subtracted from the results below
+	auto start = std::chrono::steady_clock::now();
+	for (long b = 0; b < nBlocks; b++) {
+		for (int i = 0; i < BLOCK_SIZE; i++) {
+			stimulate(module, nChannels, args.frame + b * BLOCK_SIZE + i);
+		}
+	}
+	double stimulusNs = elapsedNs(start) / (nBlocks * BLOCK_SIZE);
+
+	allocations = 0;
+	countAllocations = true;
+	for (long b = 0; b < nBlocks; b++) {
+		start = std::chrono::steady_clock::now();
+		for (int i = 0; i < BLOCK_SIZE; i++) {
+			stimulate(module, nChannels, args.frame);
+			module->process(args);
+			args.frame++;
+		}
+		blockNs.push_back(elapsedNs(start) / BLOCK_SIZE);
+	}
+	countAllocations = false;
+
+	delete module;
+
+	return summarise(blockNs, stimulusNs);
+
+}
+
+static float slewTarget(int64_t frame) {
+	return (frame % 960) < 480 ? 5.0f : -5.0f;
+}
+
+static void setSlewTarget(float &target, int64_t frame) {
+	target = slewTarget(frame);
+}
+
+static void setSlewTarget(simd::float_4 &target, int64_t frame) {
+	for (int k = 0; k < 4; k++) {
+		target[k] = slewTarget(frame + k * 61);
+	}
+}
+
+static volatile float sink;
+
+static void keep(float v) {
+	sink = v;
+}
+
+static void keep(simd::float_4 v) {
+	sink = v[0] + v[1] + v[2] + v[3];
+}
+
+/*
+* The shared slew limiter alone, as SLN and Generative drive it: parameters set every sample and a target that jumps
+* between -5V and 5V every 10ms, in a different phase on each lane.
+*/
+template <typename T>
+static Result measureSlew(long nSamples) {
+
+	ah::digital::SlewLimiter<T> slew;
+	T sum = 0.0f;
+
+	long nBlocks = std::max(1L, nSamples / BLOCK_SIZE);
+	std::vector<double> blockNs;
+	blockNs.reserve(nBlocks);
+
+	allocations = 0;
+	countAllocations = true;
+	int64_t frame = 0;
+	for (long b = 0; b < nBlocks; b++) {
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < BLOCK_SIZE; i++) {
+			T target;
+			setSlewTarget(target, frame);
+			slew.setParams(0.5f, 0.5f, 1.0f / SAMPLE_RATE);
+			sum += slew.process(target);
+			frame++;
+		}
+		blockNs.push_back(elapsedNs(start) / BLOCK_SIZE);
+	}
+	countAllocations = false;
+
+	// Keep the results live
+	keep(sum);
+
+	return summarise(blockNs, 0.0);
+
+}
+
+int main(int argc, char **argv) {
+
+	long nSamples = argc > 1 ? std::atol(argv[1]) : 10 * (long)SAMPLE_RATE;
+	std::string filter = argc > 2 ? argv[2] : "";
+
+	random::init();
+
+	Plugin *plugin = new Plugin;
+	init(plugin);
+
+	std::printf("module,channels,ns_per_sample,p99_ns_per_sample,allocations\n");
+
+	for (Model *model : plugin->models) {
+		if (!filter.empty() && model->slug.find(filter) == std::string::npos) {
+			continue;
+		}
+		for (int nChannels : CHANNELS) {
+			Result r = measure(model, nChannels, nSamples);
+			std::printf("%s,%d,%.1f,%.1f,%ld\n", model->slug.c_str(), nChannels, r.nsPerSample, r.p99NsPerSample, r.allocations);
+			std::fflush(stdout);
+		}
+	}
+
+	// Shared DSP, reported against the lanes it runs
+	const std::string SLEW_FLOAT = "SlewLimiter<float>";
+	const std::string SLEW_FLOAT_4 = "SlewLimiter<float_4>";
+	if (filter.empty() || SLEW_FLOAT.find(filter) != std::string::npos) {
+		Result r = measureSlew<float>(nSamples);
+		std::printf("%s,%d,%.1f,%.1f,%ld\n", SLEW_FLOAT.c_str(), 1, r.nsPerSample, r.p99NsPerSample, r.allocations);
+	}
+	if (filter.empty() || SLEW_FLOAT_4.find(filter) != std::string::npos) {
+		Result r = measureSlew<simd::float_4>(nSamples);
+		std::printf("%s,%d,%.1f,%.1f,%ld\n", SLEW_FLOAT_4.c_str(), 4, r.nsPerSample, r.p99NsPerSample, r.allocations);
+	}
+
+	return 0;
+
+}
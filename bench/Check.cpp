@@ -0,0 +1,351 @@
+/*
+* Headless checks of shared DSP and music code against copies of the implementations they replaced. Each check prints
+* one line with its result, and the run exits non-zero if any check fails.
+*
+* Build and run with `make check`.
+*/
+
+#include <cmath>
+#include <cstdio>
+
+#include "rack.hpp"
+
+#include "../src/AHCommon.hpp"
+
+using namespace ah;
+
+static int failures = 0;
+
+static void report(const char *name, long cases, long failed) {
+	std::printf("%-40s %10ld cases %8ld failed  %s\n", name, cases, failed, failed ? "FAIL" : "ok");
+	if (failed) {
+		failures++;
+	}
+}
+
+// The notes of a scale in semitones above the root, ending on the octave
+static const int *getScale(int scale, int *notesInScale) {
+	switch (scale){
+		case music::SCALE_CHROMATIC:	*notesInScale = LENGTHOF(music::ASCALE_CHROMATIC); return music::ASCALE_CHROMATIC;
+		case music::SCALE_IONIAN:	*notesInScale = LENGTHOF(music::ASCALE_IONIAN); return music::ASCALE_IONIAN;
+		case music::SCALE_DORIAN:	*notesInScale = LENGTHOF(music::ASCALE_DORIAN); return music::ASCALE_DORIAN;
+		case music::SCALE_PHRYGIAN:	*notesInScale = LENGTHOF(music::ASCALE_PHRYGIAN); return music::ASCALE_PHRYGIAN;
+		case music::SCALE_LYDIAN:	*notesInScale = LENGTHOF(music::ASCALE_LYDIAN); return music::ASCALE_LYDIAN;
+		case music::SCALE_MIXOLYDIAN:	*notesInScale = LENGTHOF(music::ASCALE_MIXOLYDIAN); return music::ASCALE_MIXOLYDIAN;
+		case music::SCALE_AEOLIAN:	*notesInScale = LENGTHOF(music::ASCALE_AEOLIAN); return music::ASCALE_AEOLIAN;
+		case music::SCALE_LOCRIAN:	*notesInScale = LENGTHOF(music::ASCALE_LOCRIAN); return music::ASCALE_LOCRIAN;
+		case music::SCALE_MAJOR_PENTA:	*notesInScale = LENGTHOF(music::ASCALE_MAJOR_PENTA); return music::ASCALE_MAJOR_PENTA;
+		case music::SCALE_MINOR_PENTA:	*notesInScale = LENGTHOF(music::ASCALE_MINOR_PENTA); return music::ASCALE_MINOR_PENTA;
+		case music::SCALE_HARMONIC_MINOR:	*notesInScale = LENGTHOF(music::ASCALE_HARMONIC_MINOR); return music::ASCALE_HARMONIC_MINOR;
+		case music::SCALE_BLUES:	*notesInScale = LENGTHOF(music::ASCALE_BLUES); return music::ASCALE_BLUES;
+		default:	*notesInScale = LENGTHOF(music::ASCALE_CHROMATIC); return music::ASCALE_CHROMATIC;
+	}
+}
+
+/*
+* The scale search that QuantizerTable replaced, as it was apart from the removed debug comments.
+*/
+static float oldGetPitchFromVolts(float inVolts, int currRoot, int currScale, int *outNote, int *outInterval) {
+
+	int notesInScale = 0;
+	const int *curScaleArr = getScale(currScale, &notesInScale);
+
+	// get the octave
+	int octave = floor(inVolts);
+	float closestVal = 10.0;
+	float closestDist = 10.0;
+	int noteFound = 0;
+
+	float octaveOffset = 0;
+	if (currRoot != 0) {
+		octaveOffset = (12 - currRoot) / 12.0;
+	}
+
+	float fOctave = (float)octave - octaveOffset;
+	int scaleIndex = 0;
+	int searchOctave = 0;
+
+	do {
+
+		int degree = curScaleArr[scaleIndex]; // 0 - 11!
+		float fVoltsAboveOctave = searchOctave + degree / 12.0;
+		float fScaleNoteInVolts = fOctave + fVoltsAboveOctave;
+		float distAway = fabs(inVolts - fScaleNoteInVolts);
+
+		// Assume that the list of notes is ordered, so there is an single inflection point at the minimum value
+		if (distAway >= closestDist){
+			break;
+		} else {
+			// Let's remember this
+			closestVal = fScaleNoteInVolts;
+			closestDist = distAway;
+		}
+
+		scaleIndex++;
+
+		if (scaleIndex == notesInScale - 1) {
+			scaleIndex = 0;
+			searchOctave++;
+		}
+
+	} while (true);
+
+	if (outNote != NULL && outInterval != NULL) {
+
+		if(scaleIndex == 0) {
+			noteFound = notesInScale - 2; // NIS is a count, not index
+		} else {
+			noteFound = scaleIndex - 1;
+		}
+
+		*outNote = (currRoot + curScaleArr[noteFound]) % 12;
+		*outInterval = curScaleArr[noteFound];
+	}
+
+	return closestVal;
+
+}
+
+/*
+* getPitchFromVolts against the old search, over -10V to 10V in steps of 0.1 cent for every root and scale. The two
+* differ by float rounding only, so away from the midway point between two scale notes they must agree on note and
+* interval, and on pitch to within rounding.
+*
+* Inputs exactly midway between two scale notes now round to the lower note. Within rounding of a midpoint the old
+* search could go either way, so there the new result is only required to be the lower of the two notes.
+*/
+static void checkQuantizer() {
+
+	const float MIDPOINT_TOLERANCE = 1e-5f;	// Volts, well above float rounding at 10V
+	const float PITCH_TOLERANCE = 1e-5f;
+
+	long cases = 0;
+	long failed = 0;
+	long midpoints = 0;
+
+	for (int root = 0; root < music::NUM_NOTES; root++) {
+		for (int scale = 0; scale < music::NUM_SCALES; scale++) {
+			for (long i = -100000; i <= 100000; i++) {
+
+				float v = i * 1e-4;
+
+				int oldNote, oldInterval;
+				float oldPitch = oldGetPitchFromVolts(v, root, scale, &oldNote, &oldInterval);
+
+				int note, interval;
+				float pitch = music::getPitchFromVolts(v, root, scale, &note, &interval);
+
+				cases++;
+
+				if (note == oldNote && interval == oldInterval && std::fabs(pitch - oldPitch) <= PITCH_TOLERANCE) {
+					continue;
+				}
+
+				// A near tie between two scale notes, the new result must be the lower
+				float midpoint = 0.5f * (pitch + oldPitch);
+				if (std::fabs(v - midpoint) <= MIDPOINT_TOLERANCE && pitch < oldPitch) {
+					midpoints++;
+					continue;
+				}
+
+				if (failed < 10) {
+					std::printf("  quantizer: root %d scale %d in %.5fV: old %.5fV note %d interval %d, new %.5fV note %d interval %d\n",
+						root, scale, v, oldPitch, oldNote, oldInterval, pitch, note, interval);
+				}
+				failed++;
+
+			}
+		}
+	}
+
+	report("getPitchFromVolts vs old search", cases, failed);
+	std::printf("  %ld inputs within %gV of a midpoint took the lower note\n", midpoints, MIDPOINT_TOLERANCE);
+
+	// Exact midpoints. Multiples of 1/8V are exact in float and land on every half semitone, so where one is equidistant
+	// from two scale notes the lower must be chosen
+	cases = 0;
+	failed = 0;
+	for (int root = 0; root < music::NUM_NOTES; root++) {
+		for (int scale = 0; scale < music::NUM_SCALES; scale++) {
+
+			int nDegrees = 0;
+			const int *degrees = getScale(scale, &nDegrees);
+
+			for (int j = -80; j <= 80; j++) {
+
+				float v = j / 8.0f;
+				double semis = j * 1.5 - root;
+				double octave = std::floor(semis / 12.0) * 12.0;
+				double pos = semis - octave;
+
+				// Nearest scale notes either side, the scale ends on the octave so there is always one above
+				double below = 0.0;
+				double above = 12.0;
+				for (int d = nDegrees - 1; d >= 0; d--) {
+					if (degrees[d] > pos) {
+						above = degrees[d];
+					} else {
+						below = degrees[d];
+						break;
+					}
+				}
+				if (pos - below != above - pos) {
+					continue;
+				}
+
+				cases++;
+				float expected = (octave + root + below) / 12.0;
+				float pitch = music::getPitchFromVolts(v, root, scale);
+				if (std::fabs(pitch - expected) > PITCH_TOLERANCE) {
+					if (failed < 10) {
+						std::printf("  quantizer: root %d scale %d midpoint %.5fV: expected %.5fV, got %.5fV\n",
+							root, scale, v, expected, pitch);
+					}
+					failed++;
+				}
+
+			}
+		}
+	}
+
+	report("getPitchFromVolts midpoints round down", cases, failed);
+
+}
+
+/*
+* The rise and fall that SLN and Generative used before SlewLimiter, for one voltage.
+*/
+struct OldSlew {
+
+	// minimum and maximum slopes in volts per second
+	const float slewMin = 0.1f;
+	const float slewMax = 10000.0f;
+	const float slewRatio = slewMin / slewMax;
+
+	// Amount of extra slew per voltage difference
+	const float shapeScale = 1.0f / 10.0f;
+
+	float current = 0.0f;
+
+	float process(float target, float speed, float shape, float sampleTime) {
+
+		float slew = slewMax * powf(slewRatio, speed);
+
+		// Rise
+		if (target > current) {
+			current += slew * crossfade(1.0f, shapeScale * (target - current), shape) * sampleTime;
+			if (current > target) // Trap overshoot
+				current = target;
+		}
+		// Fall
+		else if (target < current) {
+			current -= slew * crossfade(1.0f, shapeScale * (current - target), shape) * sampleTime;
+			if (current < target) // Trap overshoot
+				current = target;
+		}
+
+		return current;
+
+	}
+
+};
+
+// Each step must move towards the target and stop on it, never past it
+static bool overshoots(float last, float value, float target) {
+	if (last < target) {
+		return value < last || value > target;
+	} else if (last > target) {
+		return value > last || value < target;
+	} else {
+		return value != target;
+	}
+}
+
+/*
+* SlewLimiter<float> and SlewLimiter<float_4> against the old rise and fall, over every combination of a range of
+* speeds and shapes. Targets jump at random between -10V and 10V, rising and falling, and each lane of the float_4
+* has its own. The two differ by float rounding only, so must track each other closely and neither may overshoot.
+*/
+static void checkSlewLimiter() {
+
+	const float SAMPLE_TIME = 1.0f / 48000.0f;
+	const float TOLERANCE = 1e-3f; // Volts, rounding accumulated over the slowest approaches
+	const float SPEEDS[] = {0.0f, 0.25f, 0.5f, 0.75f, 1.0f};
+	const float SHAPES[] = {0.0f, 0.25f, 0.5f, 0.75f, 1.0f};
+	const int SAMPLES = 100000;
+
+	long cases = 0;
+	long failed = 0;
+	long overshoot = 0;
+
+	for (float speed : SPEEDS) {
+		for (float shape : SHAPES) {
+
+			core::Random rng(1);
+			digital::SlewLimiter<float> slew;
+			digital::SlewLimiter<simd::float_4> slew4;
+			OldSlew old[5];
+			float target[5] = {};
+			int hold[5] = {};
+
+			for (int i = 0; i < SAMPLES; i++) {
+
+				// A new target for each voltage every 1 to 2000 samples, so some are reached and some are not
+				for (int k = 0; k < 5; k++) {
+					if (--hold[k] <= 0) {
+						target[k] = rng.uniform() * 20.0f - 10.0f;
+						hold[k] = 1 + rng.integer(2000);
+					}
+				}
+
+				float last = slew.value;
+				simd::float_4 last4 = slew4.value;
+
+				slew.setParams(speed, shape, SAMPLE_TIME);
+				float value = slew.process(target[0]);
+				slew4.setParams(speed, shape, SAMPLE_TIME);
+				simd::float_4 value4 = slew4.process(simd::float_4(target[1], target[2], target[3], target[4]));
+
+				float expected = old[0].process(target[0], speed, shape, SAMPLE_TIME);
+				cases++;
+				if (overshoots(last, value, target[0])) {
+					overshoot++;
+				}
+				if (std::fabs(value - expected) > TOLERANCE) {
+					if (failed < 10) {
+						std::printf("  slew float: speed %g shape %g sample %d: old %.6fV, new %.6fV\n", speed, shape, i, expected, value);
+					}
+					failed++;
+				}
+
+				for (int k = 0; k < 4; k++) {
+					expected = old[k + 1].process(target[k + 1], speed, shape, SAMPLE_TIME);
+					cases++;
+					if (overshoots(last4[k], value4[k], target[k + 1])) {
+						overshoot++;
+					}
+					if (std::fabs(value4[k] - expected) > TOLERANCE) {
+						if (failed < 10) {
+							std::printf("  slew float_4 lane %d: speed %g shape %g sample %d: old %.6fV, new %.6fV\n", k, speed, shape, i, expected, value4[k]);
+						}
+						failed++;
+					}
+				}
+
+			}
+		}
+	}
+
+	report("SlewLimiter vs old slew", cases, failed);
+	report("SlewLimiter overshoot", cases, overshoot);
+
+}
+
+int main(int argc, char **argv) {
+
+	checkQuantizer();
+	checkSlewLimiter();
+
+	return failures ? 1 : 0;
+
+}
@@ -4,6 +4,150 @@
 
 namespace ah {
 
+namespace core {
+
+void Random::seed(uint64_t seedValue) {
+	for (int i = 0; i < 2; i++) {
+		uint64_t z = (seedValue += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		z = z ^ (z >> 31);
+		s[2 * i] = (uint32_t)z;
+		s[2 * i + 1] = (uint32_t)(z >> 32);
+	}
+}
+
+/*
+* Tables for Marsaglia and Tsang's 128-layer ziggurat (Journal of Statistical Software 5(8), 2000). A draw lands
+* inside its layer's rectangle about 99% of the time, which costs one multiply and one compare.
+*/
+struct Ziggurat {
+
+	static const int LAYERS = 128;
+	static constexpr double R = 3.442619855899; // Start of the tail
+	static constexpr double V = 9.91256303526217e-3; // Area of each layer
+
+	uint32_t k[LAYERS]; // Inside the layer's rectangle if |hz| < k
+	float w[LAYERS]; // hz to x
+	float f[LAYERS]; // Density at each layer's edge
+
+	Ziggurat() {
+		const double m = 2147483648.0;
+		double dn = R;
+		double tn = dn;
+		double q = V / std::exp(-0.5 * dn * dn);
+
+		k[0] = (uint32_t)((dn / q) * m);
+		k[1] = 0;
+		w[0] = (float)(q / m);
+		w[LAYERS - 1] = (float)(dn / m);
+		f[0] = 1.0f;
+		f[LAYERS - 1] = (float)std::exp(-0.5 * dn * dn);
+
+		for (int i = LAYERS - 2; i >= 1; i--) {
+			dn = std::sqrt(-2.0 * std::log(V / dn + std::exp(-0.5 * dn * dn)));
+			k[i + 1] = (uint32_t)((dn / tn) * m);
+			tn = dn;
+			f[i] = (float)std::exp(-0.5 * dn * dn);
+			w[i] = (float)(dn / m);
+		}
+	}
+
+};
+
+static const Ziggurat ziggurat;
+
+// Layer from the top bits, signed position from the rest, as the low bits of xoshiro128+ are weak
+static inline bool zigguratFast(uint32_t r, int32_t &hz, int &iz, float &x) {
+	hz = (int32_t)(r << 7);
+	iz = r >> 25;
+	x = hz * ziggurat.w[iz];
+	uint32_t magnitude = (hz < 0) ? 0u - (uint32_t)hz : (uint32_t)hz;
+	return magnitude < ziggurat.k[iz];
+}
+
+// The wedges and the tail, when the fast path misses
+static float zigguratSlow(Random &rng, int32_t hz, int iz, float x) {
+	for (;;) {
+		if (iz == 0) {
+			float xt;
+			float yt;
+			do {
+				xt = -std::log(1.0f - rng.uniform()) / (float)Ziggurat::R;
+				yt = -std::log(1.0f - rng.uniform());
+			} while (yt + yt < xt * xt);
+			return (hz > 0) ? (float)Ziggurat::R + xt : -(float)Ziggurat::R - xt;
+		}
+
+		if (ziggurat.f[iz] + rng.uniform() * (ziggurat.f[iz - 1] - ziggurat.f[iz]) < std::exp(-0.5f * x * x)) {
+			return x;
+		}
+
+		if (zigguratFast(rng.next(), hz, iz, x)) {
+			return x;
+		}
+	}
+}
+
+float Random::normal() {
+	int32_t hz;
+	int iz;
+	float x;
+	if (zigguratFast(next(), hz, iz, x)) {
+		return x;
+	}
+	return zigguratSlow(*this, hz, iz, x);
+}
+
+void Random::normal(float *out, int n) {
+	uint32_t r[16];
+	for (int j = 0; j < n; j += 16) {
+		int m = std::min(n - j, 16);
+		for (int i = 0; i < m; i++) {
+			r[i] = next();
+		}
+
+		uint32_t missed = 0;
+		for (int i = 0; i < m; i++) {
+			int32_t hz;
+			int iz;
+			missed |= (uint32_t)!zigguratFast(r[i], hz, iz, out[j + i]) << i;
+		}
+
+		while (missed) {
+			int i = __builtin_ctz(missed);
+			int32_t hz = (int32_t)(r[i] << 7);
+			int iz = r[i] >> 25;
+			out[j + i] = zigguratSlow(*this, hz, iz, out[j + i]);
+			missed &= missed - 1;
+		}
+	}
+}
+
+json_t *AHModule::toJson() {
+	json_t *rootJ = Module::toJson();
+
+	// fixed seed
+	if (fixedSeed) {
+		json_object_set_new(rootJ, "seed", json_integer((json_int_t)seed));
+	}
+
+	return rootJ;
+}
+
+void AHModule::fromJson(json_t *rootJ) {
+	Module::fromJson(rootJ);
+
+	// fixed seed
+	json_t *seedJ = json_object_get(rootJ, "seed");
+	fixedSeed = (seedJ != NULL);
+	if (seedJ)
+		seed = (uint64_t)json_integer_value(seedJ);
+	reseed();
+}
+
+} // namespace core
+
 namespace digital {
 
 int sgn(double v, double e) {
@@ -134,20 +278,33 @@ void calculateKeyboard(int inKey, float spacing, float xOff, float yOff, float *
 
 }
 
+void FixedSeedItem::onAction(const rack::event::Action &e) {
+	module->requestFixedSeed(!module->fixedSeed);
+}
+
+FixedSeedItem *createFixedSeedItem(core::AHModule *module) {
+	FixedSeedItem *item = createMenuItem<FixedSeedItem>("Fixed random seed", CHECKMARK(module->fixedSeed));
+	item->module = module;
+	return item;
+}
+
 } // namespace gui
 
 namespace music {
 
 Chord::Chord() : rootNote(0), quality(0), chord(0), modeDegree(0), inversion(0), octave(0) {
-	setVoltages(defaultChord.formula, 12);
+	// The default chord has no transposed notes, so the offset is never used
+	for (int j = 0; j < 6; j++) {
+		outVolts[j] = getVoltsFromPitch(defaultChord.formula[j], rootNote) + octave;
+	}
 }
 
-void Chord::setVoltages(const std::vector<int> &chordArray, int offset) {
+void Chord::setVoltages(const int *chordArray, int offset, core::Random &rng) {
 	for (int j = 0; j < 6; j++) {
 		if (chordArray[j] < 0) {
 			int off = offset;
 			if (offset == 0) { // if offset = 0, randomise offset per note
-				off = (rand() % 3 + 1) * 12;
+				off = (rng.integer(3) + 1) * 12;
 			}
 			outVolts[j] = getVoltsFromPitch(chordArray[j] + off,rootNote) + octave;
 		} else {
@@ -156,7 +313,30 @@ void Chord::setVoltages(const std::vector<int> &chordArray, int offset) {
 	}
 }
 
-ChordDef ChordTable[NUM_CHORDS] { // Move to Legacy module
+void Chord::setVoltages(const InversionDefinition &inv, int offset, core::Random &rng) {
+	float base = getVoltsFromPitch(0, rootNote) + octave;
+	switch (offset) {
+		case 12:
+		case 24:
+		case 36: {
+			const float *voicing = inv.voicings[offset / 12 - 1];
+			for (int j = 0; j < 6; j++) {
+				outVolts[j] = voicing[j] + base;
+			}
+		} break;
+		case 0: { // if offset = 0, randomise offset per note, one draw covers all 6 notes
+			int r = rng.integer(729); // 3^6
+			for (int j = 0; j < 6; j++) {
+				outVolts[j] = inv.voicings[r % 3][j] + base;
+				r /= 3;
+			}
+		} break;
+		default:
+			setVoltages(inv.formula, offset, rng);
+	}
+}
+
+constexpr ChordDef ChordTable[NUM_CHORDS] { // Move to Legacy module
 	{	0	,"None",	{	-24	,	-24	,	-24	,	-24	,	-24	,	-24	},{	-24	,	-24	,	-24	,	-24	,	-24	,	-24	},{	-24	,	-24	,	-24	,	-24	,	-24	,	-24	}},
 	{	1	,"M",		{	0	,	4	,	7	,	-24	,	-20	,	-17	},{	12	,	4	,	7	,	-12	,	-20	,	-17	},{	12	,	16	,	7	,	-12	,	-8	,	-17	}},
 	{	2	,"M#5",		{	0	,	4	,	8	,	-24	,	-20	,	-16	},{	12	,	4	,	8	,	-12	,	-20	,	-16	},{	12	,	16	,	8	,	-12	,	-8	,	-16	}},
@@ -258,110 +438,110 @@ ChordDef ChordTable[NUM_CHORDS] { // Move to Legacy module
 	{	98	,"madd9",	{	0	,	3	,	7	,	14	,	-24	,	-21	},{	12	,	3	,	7	,	14	,	-24	,	-21	},{	12	,	15	,	7	,	14	,	-12	,	-21	}},		
 };
 
-std::vector<ChordFormula> BasicChordSet {
-	{"M",			{	0	,	4	,	7}},
-	{"m",			{	0	,	3	,	7}},
-	{"5",			{	0	,	7	,	12}},
-	{"Msus2",		{	0	,	2	,	7}},
-	{"Msus4",		{	0	,	5	,	7}},
-	{"sus24",		{	0	,	2	,	5	,	7}},
-	{"7",			{	0	,	4	,	7	,	10}},
-	{"M7",			{	0	,	4	,	7	,	11}},
-	{"M7add13",		{	0	,	4	,	7	,	9	,	11	,	14	}},
-	{"M7#9#11",		{	0	,	4	,	7	,	11	,	15	,	18	}},
-	{"M7#11",		{	0	,	4	,	7	,	11	,	18}},
-	{"M7b9",		{	0	,	4	,	7	,	11	,	13}},
-	{"M7b5",		{	0	,	4	,	6	,	11}},
-	{"7#5",			{	0	,	4	,	8	,	10}},
-	{"7#5b9",		{	0	,	4	,	8	,	10	,	13}},
-	{"7#5#9",		{	0	,	4	,	8	,	10	,	15}},
-	{"7#5b9#11",	{	0	,	4	,	8	,	10	,	13	,	18	}},
-	{"M7b6",		{	0	,	4	,	8	,	11}},
-	{"M7#5",		{	0	,	4	,	8	,	11}},
-	{"M7sus4",		{	0	,	5	,	7	,	11}},
-	{"M7#5sus4",	{	0	,	5	,	8	,	11}},
-	{"7#9",			{	0	,	4	,	7	,	10	,	15}},
-	{"7#9#11",		{	0	,	4	,	7	,	10	,	15	,	18	}},
-	{"7#9b13",		{	0	,	4	,	7	,	10	,	15	,	20	}},
-	{"7#11",		{	0	,	4	,	7	,	10	,	18}},
-	{"7#11b13",		{	0	,	4	,	7	,	10	,	18	,	20	}},
-	{"7add6",		{	0	,	4	,	7	,	10	,	21}},
-	{"7b5",			{	0	,	4	,	6	,	10}},
-	{"7b6",			{	0	,	4	,	7	,	8	,	10}},
-	{"7b9",			{	0	,	4	,	7	,	10	,	13}},
-	{"7b13",		{	0	,	4	,	10	,	20}},
-	{"7b9#9",		{	0	,	4	,	7	,	10	,	13	,	15	}},
-	{"7b9#11",		{	0	,	4	,	7	,	10	,	13	,	18	}},
-	{"7b9b13",		{	0	,	4	,	7	,	10	,	13	,	20	}},
-	{"7no5",		{	0	,	4	,	10}},
-	{"7sus4",		{	0	,	5	,	7	,	10}},
-	{"7sus4b9",		{	0	,	5	,	7	,	10	,	13}},
-	{"7sus4b9b13",	{	0	,	5	,	7	,	10	,	13	,	20	}},
-	{"m7",			{	0	,	3	,	7	,	10}},
-	{"mMaj7",		{	0	,	3	,	7	,	11}},
-	{"mMaj7b6",		{	0	,	3	,	7	,	8	,	11}},
-	{"m7add11",		{	0	,	3	,	7	,	10	,	17}},
-	{"m7#5",		{	0	,	3	,	8	,	10}},
-	{"m7b5",		{	0	,	3	,	6	,	10}},
-	{"9",			{	0	,	4	,	7	,	10	,	14}},
-	{"M9",			{	0	,	4	,	7	,	11	,	14}},
-	{"M9#11",		{	0	,	4	,	7	,	11	,	14	,	18	}},
-	{"Maddb9",		{	0	,	4	,	7	,	13}},
-	{"Madd9",		{	0	,	4	,	7	,	14}},
-	{"M9#5",		{	0	,	4	,	8	,	11	,	14}},
-	{"M9b5",		{	0	,	4	,	6	,	11	,	14}},
-	{"M9#5sus4",	{	0	,	5	,	8	,	11	,	14}},
-	{"M9sus4",		{	0	,	5	,	7	,	11	,	14}},
-	{"11",			{	0	,	7	,	10	,	14	,	17}},
-	{"dim",			{	0	,	3	,	6}},
-	{"dim7M7",		{	0	,	3	,	6	,	9	,	11}},
-	{"dimM7",		{	0	,	3	,	6	,	11}},
-	{"dim7",		{	0	,	3	,	6	,	21}},
-	{"9#11",		{	0	,	4	,	7	,	10	,	14	,	18	}},
-	{"9#5",			{	0	,	4	,	8	,	10	,	14}},
-	{"9#5#11",		{	0	,	4	,	8	,	10	,	14	,	18	}},
-	{"9b5",			{	0	,	4	,	6	,	10	,	14}},
-	{"9b13",		{	0	,	4	,	10	,	14	,	20}},
-	{"9no5",		{	0	,	4	,	10	,	14}},
-	{"9sus4",		{	0	,	5	,	7	,	10	,	14}},
-	{"11b9",		{	0	,	7	,	10	,	13	,	17}},
-	{"13",			{	0	,	4	,	7	,	10	,	14	,	21}},
-	{"M13",			{	0	,	4	,	7	,	11	,	14	,	21	}},
-	{"13b9",		{	0	,	4	,	7	,	10	,	13	,	21	}},
-	{"13#9",		{	0	,	4	,	7	,	10	,	15	,	21	}},
-	{"13b5",		{	0	,	4	,	6	,	9	,	10	,	14	}},
-	{"13no5",		{	0	,	4	,	10	,	14	,	21}},
-	{"13sus4",		{	0	,	5	,	7	,	10	,	14	,	21	}},
-	{"M#5",			{	0	,	4	,	8}},
-	{"M#5add9",		{	0	,	4	,	8	,	14}},
-	{"Mb5",			{	0	,	4	,	6}},
-	{"M6",			{	0	,	4	,	7	,	21}},
-	{"Mb6",			{	0	,	4	,	20}},
-	{"69#11",		{	0	,	4	,	7	,	9	,	14	,	18	}},
-	{"M6#11",		{	0	,	4	,	7	,	9	,	18}},
-	{"M6/9",		{	0	,	4	,	7	,	9	,	14}},
-	{"M6/9#11",		{	0	,	4	,	7	,	9	,	14	,	18	}},
-	{"mM9b6",		{	0	,	3	,	7	,	8	,	11	,	14	}},
-	{"m#5",			{	0	,	3	,	8}},
-	{"#5",			{	0	,	3	,	8	,	10	,	14}},
-	{"m6",			{	0	,	3	,	5	,	7	,	21}},
-	{"m69",			{	0	,	3	,	7	,	9	,	14}},
-	{"mb6M7",		{	0	,	3	,	8	,	11}},
-	{"mb6b9",		{	0	,	3	,	8	,	13}},
-	{"m9",			{	0	,	3	,	7	,	10	,	14}},
-	{"m9b5",		{	0	,	3	,	10	,	14	,	18}},
-	{"mM9",			{	0	,	3	,	7	,	11	,	14}},
-	{"m11",			{	0	,	3	,	7	,	10	,	14	,	17	}},
-	{"m11A5",		{	0	,	3	,	8	,	10	,	14	,	17	}},
-	{"m11b5",		{	0	,	3	,	10	,	14	,	17	,	18	}},
-	{"augadd#9",	{	0	,	4	,	8	,	15}},
-	{"madd4",		{	0	,	3	,	5	,	7}},
-	{"madd9",		{	0	,	3	,	7	,	14}},
+constexpr ChordFormula BasicChordSet[NUM_BASIC_CHORDS] {
+	{"M",			3,	{0, 4, 7}},
+	{"m",			3,	{0, 3, 7}},
+	{"5",			3,	{0, 7, 12}},
+	{"Msus2",		3,	{0, 2, 7}},
+	{"Msus4",		3,	{0, 5, 7}},
+	{"sus24",		4,	{0, 2, 5, 7}},
+	{"7",			4,	{0, 4, 7, 10}},
+	{"M7",			4,	{0, 4, 7, 11}},
+	{"M7add13",		6,	{0, 4, 7, 9, 11, 14}},
+	{"M7#9#11",		6,	{0, 4, 7, 11, 15, 18}},
+	{"M7#11",		5,	{0, 4, 7, 11, 18}},
+	{"M7b9",		5,	{0, 4, 7, 11, 13}},
+	{"M7b5",		4,	{0, 4, 6, 11}},
+	{"7#5",			4,	{0, 4, 8, 10}},
+	{"7#5b9",		5,	{0, 4, 8, 10, 13}},
+	{"7#5#9",		5,	{0, 4, 8, 10, 15}},
+	{"7#5b9#11",	6,	{0, 4, 8, 10, 13, 18}},
+	{"M7b6",		4,	{0, 4, 8, 11}},
+	{"M7#5",		4,	{0, 4, 8, 11}},
+	{"M7sus4",		4,	{0, 5, 7, 11}},
+	{"M7#5sus4",	4,	{0, 5, 8, 11}},
+	{"7#9",			5,	{0, 4, 7, 10, 15}},
+	{"7#9#11",		6,	{0, 4, 7, 10, 15, 18}},
+	{"7#9b13",		6,	{0, 4, 7, 10, 15, 20}},
+	{"7#11",		5,	{0, 4, 7, 10, 18}},
+	{"7#11b13",		6,	{0, 4, 7, 10, 18, 20}},
+	{"7add6",		5,	{0, 4, 7, 10, 21}},
+	{"7b5",			4,	{0, 4, 6, 10}},
+	{"7b6",			5,	{0, 4, 7, 8, 10}},
+	{"7b9",			5,	{0, 4, 7, 10, 13}},
+	{"7b13",		4,	{0, 4, 10, 20}},
+	{"7b9#9",		6,	{0, 4, 7, 10, 13, 15}},
+	{"7b9#11",		6,	{0, 4, 7, 10, 13, 18}},
+	{"7b9b13",		6,	{0, 4, 7, 10, 13, 20}},
+	{"7no5",		3,	{0, 4, 10}},
+	{"7sus4",		4,	{0, 5, 7, 10}},
+	{"7sus4b9",		5,	{0, 5, 7, 10, 13}},
+	{"7sus4b9b13",	6,	{0, 5, 7, 10, 13, 20}},
+	{"m7",			4,	{0, 3, 7, 10}},
+	{"mMaj7",		4,	{0, 3, 7, 11}},
+	{"mMaj7b6",		5,	{0, 3, 7, 8, 11}},
+	{"m7add11",		5,	{0, 3, 7, 10, 17}},
+	{"m7#5",		4,	{0, 3, 8, 10}},
+	{"m7b5",		4,	{0, 3, 6, 10}},
+	{"9",			5,	{0, 4, 7, 10, 14}},
+	{"M9",			5,	{0, 4, 7, 11, 14}},
+	{"M9#11",		6,	{0, 4, 7, 11, 14, 18}},
+	{"Maddb9",		4,	{0, 4, 7, 13}},
+	{"Madd9",		4,	{0, 4, 7, 14}},
+	{"M9#5",		5,	{0, 4, 8, 11, 14}},
+	{"M9b5",		5,	{0, 4, 6, 11, 14}},
+	{"M9#5sus4",	5,	{0, 5, 8, 11, 14}},
+	{"M9sus4",		5,	{0, 5, 7, 11, 14}},
+	{"11",			5,	{0, 7, 10, 14, 17}},
+	{"dim",			3,	{0, 3, 6}},
+	{"dim7M7",		5,	{0, 3, 6, 9, 11}},
+	{"dimM7",		4,	{0, 3, 6, 11}},
+	{"dim7",		4,	{0, 3, 6, 21}},
+	{"9#11",		6,	{0, 4, 7, 10, 14, 18}},
+	{"9#5",			5,	{0, 4, 8, 10, 14}},
+	{"9#5#11",		6,	{0, 4, 8, 10, 14, 18}},
+	{"9b5",			5,	{0, 4, 6, 10, 14}},
+	{"9b13",		5,	{0, 4, 10, 14, 20}},
+	{"9no5",		4,	{0, 4, 10, 14}},
+	{"9sus4",		5,	{0, 5, 7, 10, 14}},
+	{"11b9",		5,	{0, 7, 10, 13, 17}},
+	{"13",			6,	{0, 4, 7, 10, 14, 21}},
+	{"M13",			6,	{0, 4, 7, 11, 14, 21}},
+	{"13b9",		6,	{0, 4, 7, 10, 13, 21}},
+	{"13#9",		6,	{0, 4, 7, 10, 15, 21}},
+	{"13b5",		6,	{0, 4, 6, 9, 10, 14}},
+	{"13no5",		5,	{0, 4, 10, 14, 21}},
+	{"13sus4",		6,	{0, 5, 7, 10, 14, 21}},
+	{"M#5",			3,	{0, 4, 8}},
+	{"M#5add9",		4,	{0, 4, 8, 14}},
+	{"Mb5",			3,	{0, 4, 6}},
+	{"M6",			4,	{0, 4, 7, 21}},
+	{"Mb6",			3,	{0, 4, 20}},
+	{"69#11",		6,	{0, 4, 7, 9, 14, 18}},
+	{"M6#11",		5,	{0, 4, 7, 9, 18}},
+	{"M6/9",		5,	{0, 4, 7, 9, 14}},
+	{"M6/9#11",		6,	{0, 4, 7, 9, 14, 18}},
+	{"mM9b6",		6,	{0, 3, 7, 8, 11, 14}},
+	{"m#5",			3,	{0, 3, 8}},
+	{"#5",			5,	{0, 3, 8, 10, 14}},
+	{"m6",			5,	{0, 3, 5, 7, 21}},
+	{"m69",			5,	{0, 3, 7, 9, 14}},
+	{"mb6M7",		4,	{0, 3, 8, 11}},
+	{"mb6b9",		4,	{0, 3, 8, 13}},
+	{"m9",			5,	{0, 3, 7, 10, 14}},
+	{"m9b5",		5,	{0, 3, 10, 14, 18}},
+	{"mM9",			5,	{0, 3, 7, 11, 14}},
+	{"m11",			6,	{0, 3, 7, 10, 14, 17}},
+	{"m11A5",		6,	{0, 3, 8, 10, 14, 17}},
+	{"m11b5",		6,	{0, 3, 10, 14, 17, 18}},
+	{"augadd#9",	4,	{0, 4, 8, 15}},
+	{"madd4",		4,	{0, 3, 5, 7}},
+	{"madd9",		4,	{0, 3, 7, 14}},
 };
 
-InversionDefinition defaultChord = {0, {0, 4, 7, 0, 4, 7}, "M"};
+InversionDefinition defaultChord = {{0, 4, 7, 0, 4, 7}, 0, "M", {}};
 
-std::string noteNames[12] = {
+constexpr const char *noteNames[12] = {
 	"C",
 	"Db",
 	"D",
@@ -376,7 +556,7 @@ std::string noteNames[12] = {
 	"B",
 };
 
-std::string scaleNames[12] = {
+constexpr const char *scaleNames[12] = {
 	"Chromatic",
 	"Ionian (Major)",
 	"Dorian",
@@ -391,7 +571,7 @@ std::string scaleNames[12] = {
 	"Blues"
 };
 
-std::string intervalNames[13] {
+constexpr const char *intervalNames[13] {
 	"1",
 	"b2",
 	"2",
@@ -407,7 +587,7 @@ std::string intervalNames[13] {
 	"O"
 };
 
-std::string modeNames[7] {
+constexpr const char *modeNames[7] {
 	"Ionian (M)",
 	"Dorian",
 	"Phrygian",
@@ -417,19 +597,19 @@ std::string modeNames[7] {
 	"Locrian"
 };
 	
-std::string inversionNames[3] {
+constexpr const char *inversionNames[3] {
 	"(R)",
 	"(1)",
 	"(2)"
 };
 
-std::string qualityNames[3] {
+constexpr const char *qualityNames[3] {
 	"Maj",
 	"Min",
 	"Dim"
 };
 
-std::string NoteDegreeModeNames[12][7][7] = { // Note, Degree, Mode
+constexpr const char *NoteDegreeModeNames[12][7][7] = { // Note, Degree, Mode
 {{"C","C","C","C","C","C","C"},
 {"D","D ","Db","D","D","D","Db"},
 {"E","Eb","Eb","E","E","Eb","Eb"},
@@ -526,7 +706,7 @@ std::string NoteDegreeModeNames[12][7][7] = { // Note, Degree, Mode
 {"G#","G#","G","G#","G#","G","G"},
 {"A#","A","A","A#","A","A","A"}}};
 
-int ModeQuality[7][7] {
+constexpr int ModeQuality[7][7] {
 	{MAJ,MIN,MIN,MAJ,MAJ,MIN,DIM}, // Ionian
 	{MIN,MIN,MAJ,MAJ,MIN,DIM,MAJ}, // Dorian
 	{MIN,MAJ,MAJ,MIN,DIM,MAJ,MIN}, // Phrygian
@@ -536,7 +716,7 @@ int ModeQuality[7][7] {
 	{DIM,MAJ,MIN,MIN,MAJ,MAJ,MIN}  // Locrian
 };
 
-int ModeOffset[7][7] {
+constexpr int ModeOffset[7][7] {
 	{0,0,0,0,0,0,0},		// Ionian
 	{0,0,-1,0,0,0,-1},		// Dorian
 	{0,-1,-1,0,0,-1,-1},	// Phrygian
@@ -546,7 +726,7 @@ int ModeOffset[7][7] {
 	{0,-1,-1,0,-1,-1,-1}	// Locrian
 };
 
-std::string DegreeString[7][7] {
+constexpr const char *DegreeString[7][7] {
 	{"I","ii","iii","IV","V","vi","vii°"},		// Ionian
 	{"i","ii","bIII","IV","v","vi°","bVII"},	// Dorian
 	{"i","bII","bIII","iv","v°","bVI","bvii"},	// Phrygian
@@ -557,9 +737,9 @@ std::string DegreeString[7][7] {
 };
 
 //0	1	2	3	4	5	6	7	8	9	10	11	12
-int tonicIndex[13] {1, 3, 5, 0, 2, 4, 6, 1, 3, 5, 0, 2, 4};
-int scaleIndex[7] {5, 3, 1, 6, 4, 2, 0};
-int noteIndex[13] { 
+constexpr int tonicIndex[13] {1, 3, 5, 0, 2, 4, 6, 1, 3, 5, 0, 2, 4};
+constexpr int scaleIndex[7] {5, 3, 1, 6, 4, 2, 0};
+constexpr int noteIndex[13] { 
 	NOTE_G_FLAT,
 	NOTE_D_FLAT,
 	NOTE_A_FLAT,
@@ -574,7 +754,7 @@ int noteIndex[13] {
 	NOTE_B,
 	NOTE_G_FLAT};
 
-int CIRCLE_FIFTHS [12] = {
+constexpr int CIRCLE_FIFTHS [12] = {
 	NOTE_C,
 	NOTE_G,
 	NOTE_D,
@@ -606,18 +786,18 @@ int CIRCLE_FIFTHS [12] = {
 // http://www.grantmuller.com/MidiReference/doc/midiReference/ScaleReference.html
 // Although their definition of the Blues scale is wrong
 // Added the octave note to ensure that the last note is correctly processed
-int ASCALE_CHROMATIC		[13]= {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};	// All of the notes
-int ASCALE_IONIAN			[8] = {0, 2, 4, 5, 7, 9, 11, 12};					// 1,2,3,4,5,6,7
-int ASCALE_DORIAN			[8] = {0, 2, 3, 5, 7, 9, 10, 12};					// 1,2,b3,4,5,6,b7
-int ASCALE_PHRYGIAN			[8] = {0, 1, 3, 5, 7, 8, 10, 12};					// 1,b2,b3,4,5,b6,b7
-int ASCALE_LYDIAN			[8] = {0, 2, 4, 6, 7, 9, 10, 12};					// 1,2,3,#4,5,6,7
-int ASCALE_MIXOLYDIAN		[8] = {0, 2, 4, 5, 7, 9, 10, 12};					// 1,2,3,4,5,6,b7 
-int ASCALE_AEOLIAN			[8] = {0, 2, 3, 5, 7, 8, 10, 12};					// 1,2,b3,4,5,b6,b7
-int ASCALE_LOCRIAN			[8] = {0, 1, 3, 5, 6, 8, 10, 12};					// 1,b2,b3,4,b5,b6,b7
-int ASCALE_MAJOR_PENTA		[6] = {0, 2, 4, 7, 9, 12};							// 1,2,3,5,6
-int ASCALE_MINOR_PENTA		[6] = {0, 3, 5, 7, 10, 12};							// 1,b3,4,5,b7
-int ASCALE_HARMONIC_MINOR	[8] = {0, 2, 3, 5, 7, 8, 11, 12};					// 1,2,b3,4,5,b6,7
-int ASCALE_BLUES			[7] = {0, 3, 5, 6, 7, 10, 12};						// 1,b3,4,b5,5,b7
+constexpr int ASCALE_CHROMATIC		[13]= {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};	// All of the notes
+constexpr int ASCALE_IONIAN			[8] = {0, 2, 4, 5, 7, 9, 11, 12};					// 1,2,3,4,5,6,7
+constexpr int ASCALE_DORIAN			[8] = {0, 2, 3, 5, 7, 9, 10, 12};					// 1,2,b3,4,5,6,b7
+constexpr int ASCALE_PHRYGIAN			[8] = {0, 1, 3, 5, 7, 8, 10, 12};					// 1,b2,b3,4,5,b6,b7
+constexpr int ASCALE_LYDIAN			[8] = {0, 2, 4, 6, 7, 9, 10, 12};					// 1,2,3,#4,5,6,7
+constexpr int ASCALE_MIXOLYDIAN		[8] = {0, 2, 4, 5, 7, 9, 10, 12};					// 1,2,3,4,5,6,b7 
+constexpr int ASCALE_AEOLIAN			[8] = {0, 2, 3, 5, 7, 8, 10, 12};					// 1,2,b3,4,5,b6,b7
+constexpr int ASCALE_LOCRIAN			[8] = {0, 1, 3, 5, 6, 8, 10, 12};					// 1,b2,b3,4,b5,b6,b7
+constexpr int ASCALE_MAJOR_PENTA		[6] = {0, 2, 4, 7, 9, 12};							// 1,2,3,5,6
+constexpr int ASCALE_MINOR_PENTA		[6] = {0, 3, 5, 7, 10, 12};							// 1,b3,4,5,b7
+constexpr int ASCALE_HARMONIC_MINOR	[8] = {0, 2, 3, 5, 7, 8, 11, 12};					// 1,2,b3,4,5,b6,7
+constexpr int ASCALE_BLUES			[7] = {0, 3, 5, 6, 7, 10, 12};						// 1,b3,4,b5,5,b7
 
 /*
 * Convert a root note (relative to C, C=0) and positive semi-tone offset from that root to a voltage (1V/OCT, 0V = C4 (or 3??))
@@ -655,122 +835,122 @@ int getKeyFromVolts(float volts) {
 	return round(rack::math::rescale(v, 0.0f, 10.0f, 0.0f, NUM_NOTES - 1));
 }
 
-float getPitchFromVolts(float inVolts, int currRoot, int currScale, int *outNote, int *outInterval) {
-
-	// static bool debug = true;
-	// static int poll = 5000;
-	// static int stepX = 0;
-	
-	int *curScaleArr;
-	int notesInScale = 0;
-	switch (currScale){
-		case SCALE_CHROMATIC:		curScaleArr = ASCALE_CHROMATIC;			notesInScale=LENGTHOF(ASCALE_CHROMATIC); break;
-		case SCALE_IONIAN:			curScaleArr = ASCALE_IONIAN;			notesInScale=LENGTHOF(ASCALE_IONIAN); break;
-		case SCALE_DORIAN:			curScaleArr = ASCALE_DORIAN;			notesInScale=LENGTHOF(ASCALE_DORIAN); break;
-		case SCALE_PHRYGIAN:		curScaleArr = ASCALE_PHRYGIAN;			notesInScale=LENGTHOF(ASCALE_PHRYGIAN); break;
-		case SCALE_LYDIAN:			curScaleArr = ASCALE_LYDIAN;			notesInScale=LENGTHOF(ASCALE_LYDIAN); break;
-		case SCALE_MIXOLYDIAN:		curScaleArr = ASCALE_MIXOLYDIAN;		notesInScale=LENGTHOF(ASCALE_MIXOLYDIAN); break;
-		case SCALE_AEOLIAN:			curScaleArr = ASCALE_AEOLIAN;			notesInScale=LENGTHOF(ASCALE_AEOLIAN); break;
-		case SCALE_LOCRIAN:			curScaleArr = ASCALE_LOCRIAN;			notesInScale=LENGTHOF(ASCALE_LOCRIAN); break;
-		case SCALE_MAJOR_PENTA:		curScaleArr = ASCALE_MAJOR_PENTA;		notesInScale=LENGTHOF(ASCALE_MAJOR_PENTA); break;
-		case SCALE_MINOR_PENTA:		curScaleArr = ASCALE_MINOR_PENTA;		notesInScale=LENGTHOF(ASCALE_MINOR_PENTA); break;
-		case SCALE_HARMONIC_MINOR:	curScaleArr = ASCALE_HARMONIC_MINOR;	notesInScale=LENGTHOF(ASCALE_HARMONIC_MINOR); break;
-		case SCALE_BLUES:			curScaleArr = ASCALE_BLUES;				notesInScale=LENGTHOF(ASCALE_BLUES); break;
-		default: 					curScaleArr = ASCALE_CHROMATIC;			notesInScale=LENGTHOF(ASCALE_CHROMATIC);
-	}
+QuantizerTable::QuantizerTable() {
+
+	for (int currScale = 0; currScale < NUM_SCALES; currScale++) {
+
+		const int *curScaleArr;
+		switch (currScale){
+			case SCALE_CHROMATIC:		curScaleArr = ASCALE_CHROMATIC; break;
+			case SCALE_IONIAN:			curScaleArr = ASCALE_IONIAN; break;
+			case SCALE_DORIAN:			curScaleArr = ASCALE_DORIAN; break;
+			case SCALE_PHRYGIAN:		curScaleArr = ASCALE_PHRYGIAN; break;
+			case SCALE_LYDIAN:			curScaleArr = ASCALE_LYDIAN; break;
+			case SCALE_MIXOLYDIAN:		curScaleArr = ASCALE_MIXOLYDIAN; break;
+			case SCALE_AEOLIAN:			curScaleArr = ASCALE_AEOLIAN; break;
+			case SCALE_LOCRIAN:			curScaleArr = ASCALE_LOCRIAN; break;
+			case SCALE_MAJOR_PENTA:		curScaleArr = ASCALE_MAJOR_PENTA; break;
+			case SCALE_MINOR_PENTA:		curScaleArr = ASCALE_MINOR_PENTA; break;
+			case SCALE_HARMONIC_MINOR:	curScaleArr = ASCALE_HARMONIC_MINOR; break;
+			case SCALE_BLUES:			curScaleArr = ASCALE_BLUES; break;
+			default: 					curScaleArr = ASCALE_CHROMATIC;
+		}
 
-	// get the octave
-	int octave = floor(inVolts);
-	float closestVal = 10.0;
-	float closestDist = 10.0;
-	int noteFound = 0;
+		for (int bucket = 0; bucket < NUM_NOTES; bucket++) {
 
-	// if (debug && stepX % poll == 0) {
-	// 	std::cout << "QUANT Octave: " << octave << " Scale: " << scaleNames[currScale] << " Root: " << noteNames[currRoot] << std::endl;
-	// }
+			// The scale arrays are ordered and end with the octave, so there is always a note above the bucket
+			int upperIndex = 1;
+			while (curScaleArr[upperIndex] <= bucket) {
+				upperIndex++;
+			}
 
-	float octaveOffset = 0;
-	if (currRoot != 0) {
-		octaveOffset = (12 - currRoot) / 12.0;
-	}
+			int lowerDegree = curScaleArr[upperIndex - 1];
+			int upperDegree = curScaleArr[upperIndex];
+
+			// The octave is reported as the root of the next octave, as the search did
+			int lowerInterval = lowerDegree % 12;
+			int upperInterval = upperDegree % 12;
+
+			for (int currRoot = 0; currRoot < NUM_NOTES; currRoot++) {
+				QuantizerBucket &b = buckets[currRoot][currScale][bucket];
+				// Equidistant inputs resolve to the lower note
+				b.threshold = (lowerDegree + upperDegree) * 0.5f;
+				b.lower = lowerDegree;
+				b.upper = upperDegree;
+				b.lowerNote = (currRoot + lowerInterval) % 12;
+				b.upperNote = (currRoot + upperInterval) % 12;
+				b.lowerInterval = lowerInterval;
+				b.upperInterval = upperInterval;
+			}
 
-	// if (debug && stepX % poll == 0) {
-	// 	std::cout << "QUANT Octave: " << octave << " currRoot: " << currRoot << " -> Offset: " << octaveOffset << " inVolts: " << inVolts << std::endl;
-	// }
-
-	float fOctave = (float)octave - octaveOffset;	
-	int scaleIndex = 0;
-	int searchOctave = 0;
-
-	do { 
-
-		int degree = curScaleArr[scaleIndex]; // 0 - 11!
-		float fVoltsAboveOctave = searchOctave + degree / 12.0;
-		float fScaleNoteInVolts = fOctave + fVoltsAboveOctave;
-		float distAway = fabs(inVolts - fScaleNoteInVolts);
-
-		// if (debug && stepX % poll == 0) {
-		// 	std::cout << "QUANT input: " << inVolts
-		// 	<< " index: " << scaleIndex
-		// 	<< " root: " << currRoot
-		// 	<< " octave: " << fOctave
-		// 	<< " degree: " << degree
-		// 	<< " V above O: " << fVoltsAboveOctave
-		// 	<< " note in V: " << fScaleNoteInVolts
-		// 	<< " distance: " << distAway
-		// 	<< std::endl;
-		// }
-
-		// Assume that the list of notes is ordered, so there is an single inflection point at the minimum value
-		if (distAway >= closestDist){
-			break;
-		} else {
-			// Let's remember this
-			closestVal = fScaleNoteInVolts;
-			closestDist = distAway;
 		}
 
-		scaleIndex++;
+	}
 
-		if (scaleIndex == notesInScale - 1) {
-			scaleIndex = 0;
-			searchOctave++;
-		}
+}
 
-	} while (true);
+float QuantizerTable::quantize(float inVolts, int inRoot, int inScale, int *outNote, int *outInterval) const {
 
-	if (outNote != NULL && outInterval != NULL) {
+	int currRoot = eucMod(inRoot, 12);
+	int currScale = (inScale >= 0 && inScale < NUM_SCALES) ? inScale : SCALE_CHROMATIC;
 
-		if(scaleIndex == 0) {
-			noteFound = notesInScale - 2; // NIS is a count, not index
-		} else {
-			noteFound = scaleIndex - 1;
-		}
+	// Position of the input in semitones above the nearest root at or below it
+	float semis = inVolts * 12.0f - currRoot;
+	float octave = std::floor(semis * SEMITONE);
+	float pos = semis - octave * 12.0f;
+	int bucket = rack::math::clamp((int)pos, 0, NUM_NOTES - 1);
 
-		// if (debug && stepX % poll == 0) {
-		// 	std::cout << "QUANT NIS: " << notesInScale <<  " scaleIndex: " << scaleIndex << " NF: " << noteFound << std::endl;
-		// }
+	const QuantizerBucket &b = buckets[currRoot][currScale][bucket];
 
-		int currNote = (currRoot + curScaleArr[noteFound]) % 12; // So this is the nth note of the scale; 
-		// case in point, V=0, Scale = F#m returns the 6th note, which should be C#
+	if (pos > b.threshold) {
+		if (outNote != NULL && outInterval != NULL) {
+			*outNote = b.upperNote;
+			*outInterval = b.upperInterval;
+		}
+		return octave + (currRoot + b.upper) * SEMITONE;
+	} else {
+		if (outNote != NULL && outInterval != NULL) {
+			*outNote = b.lowerNote;
+			*outInterval = b.lowerInterval;
+		}
+		return octave + (currRoot + b.lower) * SEMITONE;
+	}
 
-		// if (debug && stepX % poll == 0) {
-		// 	// Dump the note and interval, mod the size in case where we have wrapped round
+}
 
-		// 	std::cout << "QUANT Found index in scale: " << noteFound << ", currNote: "  << currNote;
-		// 	std::cout << " This is scale note: "  << curScaleArr[noteFound] << " (Interval: " << intervalNames[curScaleArr[noteFound]] << ")";
-		// 	std::cout << ": " << inVolts << " -> " << closestVal << std::endl;
+simd::float_4 QuantizerTable::quantize(simd::float_4 inVolts, int inRoot, int inScale) const {
+
+	int currRoot = eucMod(inRoot, 12);
+	int currScale = (inScale >= 0 && inScale < NUM_SCALES) ? inScale : SCALE_CHROMATIC;
+	const QuantizerBucket *scaleBuckets = buckets[currRoot][currScale];
+
+	simd::float_4 semis = inVolts * 12.0f - (float)currRoot;
+	simd::float_4 octave = simd::floor(semis * SEMITONE);
+	simd::float_4 pos = semis - octave * 12.0f;
+
+	// Gather the bucket for each lane, the comparison and result are then done across all lanes at once
+	simd::float_4 threshold;
+	simd::float_4 lower;
+	simd::float_4 upper;
+	for (int k = 0; k < 4; k++) {
+		const QuantizerBucket &b = scaleBuckets[rack::math::clamp((int)pos[k], 0, NUM_NOTES - 1)];
+		threshold[k] = b.threshold;
+		lower[k] = b.lower;
+		upper[k] = b.upper;
+	}
 
-		// }
+	return octave + ((float)currRoot + simd::ifelse(pos > threshold, upper, lower)) * SEMITONE;
 
-		*outNote = currNote;
-		*outInterval = curScaleArr[noteFound];
-	}
+}
 
-	// stepX++;
+const QuantizerTable quantizerTable;
 
-	return closestVal;
+float getPitchFromVolts(float inVolts, int currRoot, int currScale, int *outNote, int *outInterval) {
+	return quantizerTable.quantize(inVolts, currRoot, currScale, outNote, outInterval);
+}
 
+simd::float_4 getPitchFromVolts(simd::float_4 inVolts, int currRoot, int currScale) {
+	return quantizerTable.quantize(inVolts, currRoot, currScale);
 }
 
 float getPitchFromVolts(float inVolts, float inRoot, float inScale, int *outRoot, int *outScale, int *outNote, int *outInterval) {
@@ -817,84 +997,127 @@ void getRootFromMode(int inMode, int inRoot, int inTonic, int *currRoot, int *qu
 	// 	<< std::endl;
 }
 
-std::string InversionDefinition::getName(int rootNote) const {
+void InversionDefinition::formatName(char *text, size_t size, int rootNote) const {
 	if (inversion > 0) { 
 		int bassNote = (rootNote + formula[0]) % 12;
-		return music::noteNames[rootNote] + baseName + "/" + music::noteNames[bassNote];
+		snprintf(text, size, "%s%s/%s", music::noteNames[rootNote], baseName, music::noteNames[bassNote]);
 	} else {
-		return music::noteNames[rootNote] + baseName;
+		snprintf(text, size, "%s%s", music::noteNames[rootNote], baseName);
 	}
 }
 
-std::string InversionDefinition::getName(int mode, int key, int degree, int root) const {
+void InversionDefinition::formatName(char *text, size_t size, int mode, int key, int degree, int root) const {
 	if (inversion > 0) { 
 		int bassNote = (root + formula[0]) % 12;
-		return music::NoteDegreeModeNames[key][degree][mode] + baseName + "/" + music::noteNames[bassNote];
+		snprintf(text, size, "%s%s/%s", music::NoteDegreeModeNames[key][degree][mode], baseName, music::noteNames[bassNote]);
+	} else {
+		snprintf(text, size, "%s%s", music::NoteDegreeModeNames[key][degree][mode], baseName);
+	}
+}
+
+std::string InversionDefinition::getName(int rootNote) const {
+	char text[64];
+	formatName(text, sizeof(text), rootNote);
+	return text;
+}
+
+std::string InversionDefinition::getName(int mode, int key, int degree, int root) const {
+	char text[64];
+	formatName(text, sizeof(text), mode, key, degree, root);
+	return text;
+}
+
+void ChordLabel::format(char *text, size_t size) const {
+	if (!inv) {
+		text[0] = '\0';
+	} else if (mode >= 0) {
+		inv->formatName(text, size, mode, key, degree, rootNote);
 	} else {
-		return music::NoteDegreeModeNames[key][degree][mode] + baseName;
+		inv->formatName(text, size, rootNote);
+	}
+}
+
+void InversionDefinition::calculateVoicings() {
+	for (int i = 0; i < 3; i++) {
+		int off = (i + 1) * 12;
+		for (int j = 0; j < 6; j++) {
+			if (formula[j] < 0) {
+				voicings[i][j] = getVoltsFromPitch(formula[j] + off, 0);
+			} else {
+				voicings[i][j] = getVoltsFromPitch(formula[j], 0);
+			}
+		}
 	}
 }
 
-void ChordDefinition::generateInversions() {
+void ChordDefinition::generateInversions(const ChordFormula &formula) {
 
-	int rootOffset = (1 + formula.back() / 12) * 12;
+	nNotes = formula.nNotes;
+	int rootOffset = (1 + formula.root[nNotes - 1] / 12) * 12;
 
-	for(size_t i = 0; i < formula.size(); i++) {
+	for(int i = 0; i < nNotes; i++) {
 		// i is number of inversions
-		InversionDefinition inv;
+		InversionDefinition &inv = inversions[i];
 		inv.inversion = i;
 		inv.baseName = name;
 
 		calculateInversion(formula, inv.formula, i, rootOffset);
-		inversions.push_back(inv);
+		inv.calculateVoicings();
 	}
 }
 
-void ChordDefinition::calculateInversion(std::vector<int> &inputF, std::vector<int> &outputF, int inv, int rootOffset) {
-	outputF = inputF;
+void ChordDefinition::calculateInversion(const ChordFormula &inputF, int *outputF, int inv, int rootOffset) {
+	int nNotes = inputF.nNotes;
+	for (int i = 0; i < nNotes; i++) {
+		outputF[i] = inputF.root[i];
+	}
 	for (int i = 0; i < inv; i++) {
 		outputF[i] += rootOffset; 
 	}
-	std::sort(outputF.begin(), outputF.end());
+	std::sort(outputF, outputF + nNotes);
 
 	// Fill in missing notes
-	size_t nNotes = outputF.size();
-	for (size_t j = 0; j < (6 - nNotes); j++) {
-		outputF.push_back(-24 + outputF[j]); 
+	for (int j = 0; j < (6 - nNotes); j++) {
+		outputF[nNotes + j] = -24 + outputF[j]; 
 	}
 }
 
 KnownChords::KnownChords() {
-	for(size_t i = 0; i < BasicChordSet.size(); i++) {
-		ChordDefinition def;
+	chords.resize(NUM_BASIC_CHORDS);
+	for(int i = 0; i < NUM_BASIC_CHORDS; i++) {
+		ChordDefinition &def = chords[i];
 		def.id = i;
 		def.name = BasicChordSet[i].name;
-		def.formula = BasicChordSet[i].root;
-		def.generateInversions();
-		chords.push_back(def);
+		def.generateInversions(BasicChordSet[i]);
 	}
+
+	// defaultChord is defined earlier in this file, so is already initialised
+	defaultChord.calculateVoicings();
 }
 
-void KnownChords::dump() {
-	for(ChordDefinition chord: chords) {
+void KnownChords::dump() const {
+	for(const ChordDefinition &chord: chords) {
 		std::cout << chord.id << " = " << chord.name << std::endl;
-		for(InversionDefinition inv: chord.inversions) {
+		for(int j = 0; j < chord.nNotes; j++) {
+			const InversionDefinition &inv = chord.inversions[j];
 			std::stringstream ss;
-			for(size_t i = 0; i < inv.formula.size(); i++) {
+			for(size_t i = 0; i < 6; i++) {
 				if(i != 0) {
 					ss << ",";
 				}
   				ss << inv.formula[i];
 			}
-			std::cout << inv.inversion << "(" << inv.formula.size() <<  ") = " << ss.str() << std::endl;
+			std::cout << inv.inversion << "(" << chord.nNotes <<  ") = " << ss.str() << std::endl;
 		}
 	}
 }
 
-const InversionDefinition &KnownChords::getChord(Chord currChord) {
+const InversionDefinition &KnownChords::getChord(const Chord &currChord) const {
 	return chords[currChord.chord].inversions[currChord.inversion];
 }
 
+const KnownChords knownChords;
+
 } // music
 
 } // ah
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <iostream>
 
 #include "AH.hpp"
@@ -10,6 +11,8 @@ namespace core {
 
 const double PI = 3.14159265358979323846264338327950288;
 
+const int STATE_TIMEOUT = 50000; // Samples for which the last parameter change is displayed
+
 struct ParamEvent {
 
 	ParamEvent(int t, int i, float v) : pType(t), pId(i), value(v) {}
@@ -20,47 +23,203 @@ struct ParamEvent {
 
 };
 
+/*
+* xoshiro128+ generator. Every module owns one, so random streams are never shared between engine threads,
+* and can be made reproducible by fixing the seed. http://prng.di.unimi.it/
+*/
+struct Random {
+
+	uint32_t s[4];
+
+	Random(uint64_t seedValue = 0x9E3779B97F4A7C15ULL) {
+		seed(seedValue);
+	}
+
+	// Expand a 64-bit seed into the state with splitmix64, which never gives the all-zero state
+	void seed(uint64_t seedValue);
+
+	inline uint32_t next() {
+		uint32_t result = s[0] + s[3];
+		uint32_t t = s[1] << 9;
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = (s[3] << 11) | (s[3] >> 21);
+		return result;
+	}
+
+	// Uniform in [0, 1), from the top 24 bits (the low bits of xoshiro128+ are weak)
+	inline float uniform() {
+		return (next() >> 8) * (1.0f / 16777216.0f);
+	}
+
+	// Uniform integer in [0, n)
+	inline int integer(int n) {
+		return (int)(((uint64_t)next() * (uint32_t)n) >> 32);
+	}
+
+	// Standard normal, by the ziggurat method
+	float normal();
+
+	// Fill out with n standard normals. The fast path for all n runs first, then any rejections are redrawn
+	void normal(float *out, int n);
+
+};
+
+/*
+* Lock-free triple buffer for passing frames from process() to a display widget. The writer fills write() and calls
+* publish(), the reader takes the latest complete frame with read(). Neither side waits and the reader never sees a
+* frame that is being written.
+*/
+template <typename T>
+struct SnapshotBuffer {
+
+	static const int FRESH = 4; // Set in shared when it holds a frame the reader has not taken
+
+	T buffers[3] = {};
+	std::atomic<int> shared {1};
+	int writeIndex = 0; // Writer only
+	int publishedIndex = 1; // Writer only
+	int readIndex = 2;  // Reader only
+
+	T &write() {
+		return buffers[writeIndex];
+	}
+
+	void publish() {
+		publishedIndex = writeIndex;
+		writeIndex = shared.exchange(writeIndex | FRESH, std::memory_order_acq_rel) & 3;
+	}
+
+	// For writers that update a frame incrementally: publish, then carry the frame forward as the next one
+	void publishAndCopy() {
+		publish();
+		buffers[writeIndex] = buffers[publishedIndex];
+	}
+
+	// The returned frame is stable until the next call to read()
+	const T &read() {
+		if (shared.load(std::memory_order_relaxed) & FRESH) {
+			readIndex = shared.exchange(readIndex, std::memory_order_acq_rel) & 3;
+		}
+		return buffers[readIndex];
+	}
+
+};
+
 struct AHModule : rack::Module {
 
+	// Only rng is seeded here, as onReseed() overrides cannot run from the base constructor. Modules that override
+	// onReseed() call reseed() at the end of their own constructor
 	AHModule(int numParams, int numInputs, int numOutputs, int numLights = 0) {
 		config(numParams, numInputs, numOutputs, numLights);
+		seed = random::u64();
+		rng.seed(seed);
+	}
+
+	enum SeedRequest {
+		NO_SEED_REQUEST,
+		FREE_SEED_REQUEST,
+		FIXED_SEED_REQUEST
+	};
+
+	Random rng;
+	bool fixedSeed = false; // Fixed seed is saved with the patch and restored on load and reset
+	uint64_t seed = 0;
+	std::atomic<int> seedRequest {NO_SEED_REQUEST}; // Set from the UI thread, applied by process()
+
+	void reseed() {
+		if (!fixedSeed) {
+			seed = random::u64();
+		}
+		rng.seed(seed);
+		onReseed();
+	}
+
+	// Seed any other generators the module owns from rng
+	virtual void onReseed() {}
+
+	// Engine thread only, the UI uses requestFixedSeed()
+	void setFixedSeed(bool fixed) {
+		fixedSeed = fixed;
+		reseed();
 	}
 
+	void requestFixedSeed(bool fixed) {
+		seedRequest.store(fixed ? FIXED_SEED_REQUEST : FREE_SEED_REQUEST, std::memory_order_release);
+	}
+
+	inline void applySeedRequest() {
+		if (seedRequest.load(std::memory_order_relaxed) != NO_SEED_REQUEST) {
+			int request = seedRequest.exchange(NO_SEED_REQUEST, std::memory_order_acquire);
+			if (request != NO_SEED_REQUEST) {
+				setFixedSeed(request == FIXED_SEED_REQUEST);
+			}
+		}
+	}
+
+	using Module::onReset;
+
+	void onReset(const ResetEvent &e) override {
+		reseed();
+		Module::onReset(e);
+	}
+
+	json_t *toJson() override;
+	void fromJson(json_t *rootJ) override;
+
 	int stepX = 0;
 
 	bool debugFlag = false;
 
+	// Debug logging writes to std::cout from process(), so is only compiled into AH_DEBUG builds
 	inline bool debugEnabled() {
+#ifdef AH_DEBUG
 		return debugFlag;
+#else
+		return false;
+#endif
 	}
 
 	inline bool debugEnabled(int poll) {
+#ifdef AH_DEBUG
 		if (debugFlag && stepX % poll == 0) {
 			return true;
 		} else {
 			return false;
 		}
+#else
+		return false;
+#endif
 	}
 
 	bool receiveEvents = false;
 	int keepStateDisplay = 0;
-	std::string paramState = ">";
+	ParamEvent stateEvent = ParamEvent(-1, 0, 0.0f); // Last parameter event, displayed until keepStateDisplay times out
 
+	// Called from the widgets on the UI thread
 	virtual void receiveEvent(ParamEvent e) {
-		paramState = ">";
 		keepStateDisplay = 0;
 	}
 
+	// Text for the last parameter event, called by StateDisplay on the UI thread
+	virtual void getStateText(char *text, size_t size) {
+		snprintf(text, size, ">");
+	}
+
 	void step() override {
 
 		stepX++;
 
+		applySeedRequest();
+
 		// Once we start stepping, we can process events
 		receiveEvents = true;
 		// Timeout for display
-		keepStateDisplay++;
-		if (keepStateDisplay > 50000) {
-			paramState = ">"; 
+		if (keepStateDisplay <= STATE_TIMEOUT) {
+			keepStateDisplay++;
 		}
 
 	}
@@ -99,7 +258,11 @@ struct StateDisplay : TransparentWidget {
 			nvgFillColor(args.vg, nvgRGBA(0x00, 0xFF, 0xFF, 0xFF));
 
 			char text[128];
-			snprintf(text, sizeof(text), "%s", module->paramState.c_str());
+			if (module->keepStateDisplay > core::STATE_TIMEOUT) {
+				snprintf(text, sizeof(text), ">");
+			} else {
+				module->getStateText(text, sizeof(text));
+			}
 			nvgText(args.vg, pos.x + 10, pos.y + 5, text, NULL);
 		}
 	}
@@ -255,6 +418,14 @@ Vec getPosition(int type, int xSlot, int ySlot, bool xDense, bool yDense, float
 * http://www.grantmuller.com/MidiReference/doc/midiReference/ScaleReference.html */
 void calculateKeyboard(int inKey, float spacing, float xOff, float yOff, float *x, float *y, int *scale);
 
+// Context menu toggle for a module's fixed random seed
+struct FixedSeedItem : MenuItem {
+	core::AHModule *module;
+	void onAction(const rack::event::Action &e) override;
+};
+
+FixedSeedItem *createFixedSeedItem(core::AHModule *module);
+
 } // namespace gui
 
 namespace digital {
@@ -288,6 +459,88 @@ struct AHPulseGenerator {
 	}
 };
 
+/*
+* Four lanes of rack::dsp::PulseGenerator, for processing polyphonic cables with simd::float_4
+*/
+struct AHPulseGenerator4 {
+	simd::float_4 remaining = 0.f;
+
+	simd::float_4 process(float deltaTime) {
+		simd::float_4 high = remaining > 0.f;
+		remaining = simd::ifelse(high, remaining - deltaTime, remaining);
+		return high;
+	}
+
+	void trigger(simd::float_4 mask, float pulseTime) {
+		// Keep the previous pulseTime if the existing pulse would be held longer than the currently requested one.
+		remaining = simd::ifelse(mask & (simd::float_4(pulseTime) > remaining), pulseTime, remaining);
+	}
+
+	// As above, with a pulse time for each lane
+	void trigger(simd::float_4 mask, simd::float_4 pulseTime) {
+		remaining = simd::ifelse(mask & (pulseTime > remaining), pulseTime, remaining);
+	}
+
+	simd::float_4 ishigh() {
+		return remaining > 0.f;
+	}
+};
+
+// Lane mask from the low four bits of bits, as returned by simd::movemask()
+inline simd::float_4 laneMask(int bits) {
+	return simd::float_4::cast(simd::int32_4(-(bits & 1), -((bits >> 1) & 1), -((bits >> 2) & 1), -((bits >> 3) & 1)));
+}
+
+/*
+* Shaped slew towards a target, for a float or the four lanes of a simd::float_4. Each step is a crossfade between a
+* fixed rate and a rate proportional to the remaining distance, and never overshoots. Rise and fall are both computed
+* and selected by mask.
+*/
+template <typename T>
+struct SlewLimiter {
+
+	// Minimum and maximum slopes in volts per second
+	static constexpr float SLEW_MIN = 0.1f;
+	static constexpr float SLEW_MAX = 10000.0f;
+
+	// Amount of extra slew per voltage difference
+	static constexpr float SHAPE_SCALE = 1.0f / 10.0f;
+
+	T value = 0.0f;
+
+	// Step is stepFixed + stepScaled * distance
+	float stepFixed = 0.0f;
+	float stepScaled = 0.0f;
+
+	float lastSpeed = -1.0f;
+	float lastShape = -1.0f;
+	float lastSampleTime = 0.0f;
+
+	// Speed runs from fastest to slowest and shape from linear to exponential, both 0 to 1. Cheap to call every
+	// sample, the coefficients are only recomputed on a change
+	void setParams(float speed, float shape, float sampleTime) {
+		if (speed == lastSpeed && shape == lastShape && sampleTime == lastSampleTime)
+			return;
+
+		float slew = SLEW_MAX * std::pow(SLEW_MIN / SLEW_MAX, speed) * sampleTime;
+		stepFixed = slew * (1.0f - shape);
+		stepScaled = slew * shape * SHAPE_SCALE;
+		lastSpeed = speed;
+		lastShape = shape;
+		lastSampleTime = sampleTime;
+	}
+
+	// When target equals value both candidates equal the target, so no third case is needed
+	T process(T target) {
+		T diff = target - value;
+		T rise = simd::fmin(value + stepFixed + stepScaled * diff, target);
+		T fall = simd::fmax(value - stepFixed + stepScaled * diff, target);
+		value = simd::ifelse(diff > 0.0f, rise, fall);
+		return value;
+	}
+
+};
+
 struct BpmCalculator {
 
 	float timer = 0.0f;
@@ -353,8 +606,12 @@ namespace music {
 
 const static int NUM_CHORDS = 99; // FIXME Remove this
 
+const static int NUM_BASIC_CHORDS = 98;
+
 static constexpr float SEMITONE = 1.0 / 12.0;
 
+struct InversionDefinition;
+
 struct Chord {
 	int rootNote;
 	int quality;
@@ -375,26 +632,28 @@ struct Chord {
 		octave = 0;
 	}
 
-	void setVoltages(const std::vector<int> &chordArray, int offset);
+	void setVoltages(const int *chordArray, int offset, core::Random &rng);
+	void setVoltages(const InversionDefinition &inv, int offset, core::Random &rng);
 
 };
 
 struct ChordDef {
 	int number;
-	std::string name;
+	const char *name;
 	int	root[6];
 	int	first[6];
 	int	second[6];
 };
 
-extern ChordDef ChordTable[NUM_CHORDS];
+extern const ChordDef ChordTable[NUM_CHORDS];
 
 struct ChordFormula {
-	std::string name;
-	std::vector<int> root;
+	const char *name;
+	int nNotes;
+	int root[6];
 };
 
-extern std::vector<ChordFormula> BasicChordSet;
+extern const ChordFormula BasicChordSet[NUM_BASIC_CHORDS];
 
 enum Notes {
 	NOTE_C = 0,
@@ -469,12 +728,39 @@ enum RootScaling {
 	VOCT
 };
 
+/*
+* Precomputed quantizer. For every root and scale the octave above the root is split into 12 one-semitone buckets. Each
+* bucket holds the nearest scale notes below and above it and the decision point between them, so quantizing a voltage
+* is a floor, a table lookup and a single comparison rather than a search through the scale.
+*/
+struct QuantizerBucket {
+	float threshold;	// Semitones above the root at which the upper note becomes closer
+	float lower;		// Semitones above the root of the scale note at or below the bucket
+	float upper;		// Semitones above the root of the scale note above the bucket, may be the octave
+	int lowerNote;
+	int upperNote;
+	int lowerInterval;
+	int upperInterval;
+};
+
+struct QuantizerTable {
+	QuantizerBucket buckets[NUM_NOTES][NUM_SCALES][NUM_NOTES]; // Root, Scale, Bucket
+
+	QuantizerTable();
+	float quantize(float inVolts, int inRoot, int inScale, int *outNote, int *outInterval) const;
+	simd::float_4 quantize(simd::float_4 inVolts, int inRoot, int inScale) const;
+};
+
+extern const QuantizerTable quantizerTable;
+
 /*
 * Convert a V/OCT voltage to a quantized pitch, key and scale, and calculate various information about the quantised note.
 */
 
 float getPitchFromVolts(float inVolts, int inRoot, int inScale, int *outNote = NULL, int *outInterval = NULL);
 
+simd::float_4 getPitchFromVolts(simd::float_4 inVolts, int inRoot, int inScale);
+
 float getPitchFromVolts(float inVolts, float inRoot, float inScale, int *outRoot, int *outScale, int *outNote, int *outInterval);
 
 /*
@@ -496,11 +782,11 @@ int getKeyFromVolts(float volts);
 
 void getRootFromMode(int inMode, int inRoot, int inTonic, int *currRoot, int *quality);
 
-extern int ModeQuality[7][7];
+extern const int ModeQuality[7][7];
 
-extern int ModeOffset[7][7];
+extern const int ModeOffset[7][7];
 
-extern std::string DegreeString[7][7];
+extern const char * const DegreeString[7][7];
 
 // NOTE_C = 0,
 // NOTE_D_FLAT, // C Sharp
@@ -516,9 +802,9 @@ extern std::string DegreeString[7][7];
 // NOTE_B,
 
 //0	1	2	3	4	5	6	7	8	9	10	11	12
-extern int tonicIndex[13];
-extern int scaleIndex[7];
-extern int noteIndex[13];
+extern const int tonicIndex[13];
+extern const int scaleIndex[7];
+extern const int noteIndex[13];
 			
 // Reference, midi note to scale
 // 0	1
@@ -537,62 +823,105 @@ extern int noteIndex[13];
 // http://www.grantmuller.com/MidiReference/doc/midiReference/ScaleReference.html
 // Although their definition of the Blues scale is wrong
 // Added the octave note to ensure that the last note is correctly processed
-extern int ASCALE_CHROMATIC			[13];
-extern int ASCALE_IONIAN			[8];
-extern int ASCALE_DORIAN			[8];
-extern int ASCALE_PHRYGIAN			[8];
-extern int ASCALE_LYDIAN			[8];
-extern int ASCALE_MIXOLYDIAN		[8];
-extern int ASCALE_AEOLIAN			[8];
-extern int ASCALE_LOCRIAN			[8];
-extern int ASCALE_MAJOR_PENTA		[6];
-extern int ASCALE_MINOR_PENTA		[6];
-extern int ASCALE_HARMONIC_MINOR	[8];
-extern int ASCALE_BLUES				[7];
+extern const int ASCALE_CHROMATIC			[13];
+extern const int ASCALE_IONIAN			[8];
+extern const int ASCALE_DORIAN			[8];
+extern const int ASCALE_PHRYGIAN			[8];
+extern const int ASCALE_LYDIAN			[8];
+extern const int ASCALE_MIXOLYDIAN		[8];
+extern const int ASCALE_AEOLIAN			[8];
+extern const int ASCALE_LOCRIAN			[8];
+extern const int ASCALE_MAJOR_PENTA		[6];
+extern const int ASCALE_MINOR_PENTA		[6];
+extern const int ASCALE_HARMONIC_MINOR	[8];
+extern const int ASCALE_BLUES				[7];
 
-extern int CIRCLE_FIFTHS [12];
+extern const int CIRCLE_FIFTHS [12];
 
-extern std::string noteNames[12];
+extern const char * const noteNames[12];
 
-extern std::string scaleNames[12];
+extern const char * const scaleNames[12];
 
-extern std::string intervalNames[13];
+extern const char * const intervalNames[13];
 
-extern std::string modeNames[7];
+extern const char * const modeNames[7];
 
-extern std::string inversionNames[3];
+extern const char * const inversionNames[3];
 
-extern std::string qualityNames[3];
+extern const char * const qualityNames[3];
 
-extern std::string NoteDegreeModeNames[12][7][7];
+extern const char * const NoteDegreeModeNames[12][7][7];
 
+// Always 6 notes, shorter chords are padded with repeated notes 24 semitones lower (see Chord::setVoltages)
 struct InversionDefinition {
+	int formula[6];
 	int inversion;
-	std::vector<int> formula;
-	std::string baseName;
+	const char *baseName;
+	float voicings[3][6]; // Voltages above the root for repeated notes offset by 12, 24 and 36 semitones
 
+	void calculateVoicings();
+
+	void formatName(char *text, size_t size, int rootNote) const;
+	void formatName(char *text, size_t size, int mode, int key, int degree, int rootNote) const;
 	std::string getName(int rootNote) const;
 	std::string getName(int mode, int key, int degree, int rootNote) const;
 };
 
+/*
+* Name of a chord as indexes into the constant name tables, so process() can publish it without building strings.
+* The text is formatted on the UI thread.
+*/
+struct ChordLabel {
+	const InversionDefinition *inv = NULL;
+	int rootNote = 0;
+	int mode = -1; // If set, name the chord by its degree in key and mode
+	int key = 0;
+	int degree = 0;
+
+	void set(const InversionDefinition &invDef, int root) {
+		inv = &invDef;
+		rootNote = root;
+		mode = -1;
+	}
+
+	void set(const InversionDefinition &invDef, int m, int k, int d, int root) {
+		inv = &invDef;
+		rootNote = root;
+		mode = m;
+		key = k;
+		degree = d;
+	}
+
+	void clear() {
+		inv = NULL;
+	}
+
+	void format(char *text, size_t size) const;
+};
+
 struct ChordDefinition {
 	int id;
-	std::string name;
-	std::vector<int> formula;
-	std::vector<InversionDefinition> inversions;
+	const char *name;
+	int nNotes;
+	InversionDefinition inversions[6]; // One per note in the chord
 
-	void generateInversions();
-	void calculateInversion(std::vector<int> &inputF, std::vector<int> &outputF, int inv, int rootOffset);
+	void generateInversions(const ChordFormula &formula);
+	void calculateInversion(const ChordFormula &inputF, int *outputF, int inv, int rootOffset);
 };
 
+/*
+* The chord database, generated once from BasicChordSet and shared read-only by all modules
+*/
 struct KnownChords {
 	std::vector<ChordDefinition> chords;
 
 	KnownChords();
-	void dump();
-	const InversionDefinition &getChord(Chord chord);
+	void dump() const;
+	const InversionDefinition &getChord(const Chord &chord) const;
 };
 
+extern const KnownChords knownChords;
+
 extern InversionDefinition defaultChord;
 
 } // namespace music
@@ -633,14 +962,19 @@ struct ImperfectState {
 		bpm = 0.0;
 	}
 
-	void jitter(ImperfectSetting &setting) {
+	void jitter(ImperfectSetting &setting, ah::core::Random &rng) {
+		float rnd[2];
+		rng.normal(rnd, 2);
+		jitter(setting, rnd[0], rnd[1]);
+	}
+
+	// Jitter from standard normals drawn by the caller, so many channels can be drawn in one call
+	void jitter(ImperfectSetting &setting, float rndD, float rndG) {
 		// Determine delay and gate times for all active outputs
-		double rndD = clamp(random::normal(), -2.0f, 2.0f);
-		delayTime = clamp(setting.dlyLen + setting.dlySpr * rndD, 0.0f, 100.0f);
+		delayTime = clamp(setting.dlyLen + setting.dlySpr * clamp(rndD, -2.0f, 2.0f), 0.0f, 100.0f);
 
 		// The modified gate time cannot be earlier than the start of the delay
-		double rndG = clamp(random::normal(), -2.0f, 2.0f);
-		gateTime = clamp(setting.gateLen + setting.gateSpr * rndG, ah::digital::TRIGGER, 100.0f);
+		gateTime = clamp(setting.gateLen + setting.gateSpr * clamp(rndG, -2.0f, 2.0f), ah::digital::TRIGGER, 100.0f);
 	}
 
 	void fixed(float delay, float gate) {
@@ -1,72 +1,66 @@
 #include "AH.hpp"
 #include "AHCommon.hpp"
 
+#include <cstring>
 #include <iostream>
 
-struct Arpeggio2 {
-
-	std::vector<unsigned int> indexes;
-	unsigned int index = 0;
-	unsigned int offset = 0;	
-	unsigned int nPitches = 0;
-	bool repeatEnds = false;
-
-	Arpeggio2() {
-		indexes.push_back(0);
-		nPitches = 1;
-	}
+/*
+* Index sequences for every arpeggio shape, at every pitch count and for both settings of repeatEnds, built once. A
+* restart then only selects a sequence, so nothing is allocated or filled on the audio thread.
+*/
+struct Arpeggio2Tables {
 
-	virtual const std::string & getName() = 0;
+	static const unsigned int NUM_ARPS = 8;
+	static const unsigned int MAX_PITCHES = 16;
+	static const unsigned int MAX_LENGTH = 64; // The crab round trips over 16 pitches are the longest, at 55
 
-	virtual void initialise(unsigned int _nPitches, unsigned int _offset, bool _repeatEnds) {
-		nPitches = _nPitches;
-		offset = _offset;
-		repeatEnds = _repeatEnds;
-	};
-	
-	void advance() {
-		// std::cout << "ADV" << std::endl;
-		index++;
-	}
+	struct Sequence {
 
-	void reset() {
-		// std::cout << "RES" << std::endl;
-		index = offset;
-	}
+		unsigned int length = 0;
+		unsigned char indexes[MAX_LENGTH];
 
-	void randomize() {
-		int length = nPitches - offset;
-		int p1 = (rand() % length) + offset;
-		int p2 = (rand() % length) + offset;
-		int tries = 0;
-
-		while (p1 == p2 && tries < 5) { // Make some effort to change the sequence, break after 5 attempts
-			p2 = (rand() % length) + offset;
-			tries++;
+		void push(unsigned int i) {
+			if (length < MAX_LENGTH) {
+				indexes[length++] = i;
+			}
 		}
 
-		// std::cout << "RND " << length << " " << p1 << " " << p2 << " "; 
-
-		int t = indexes[p1];
-		indexes[p1] = indexes[p2];
-		indexes[p2] = t;
+	};
 
-		// for (int i = 0; i < nPitches; i++) {
-		// 	std::cout << indexes[i];
-		// }
+	std::string names[NUM_ARPS] = {"Straight-R", "Straight-L", "Straight-RL", "Straight-LR", "Crab-R", "Crab-L", "Crab-RL", "Crab-LR"};
 
-		// std::cout << std::endl;
+	Sequence sequences[NUM_ARPS][MAX_PITCHES + 1][2]; // By arpeggio, number of pitches, repeatEnds
 
+	static const Arpeggio2Tables &get() {
+		static const Arpeggio2Tables tables;
+		return tables;
 	}
 
-	unsigned int getPitch() {
-		// std::cout << "OUT " << index << " " << indexes[index] << std::endl;
-		return indexes[index];
+	Arpeggio2Tables() {
+		for (unsigned int arp = 0; arp < NUM_ARPS; arp++) {
+			for (unsigned int nPitches = 1; nPitches <= MAX_PITCHES; nPitches++) {
+				for (int repeatEnds = 0; repeatEnds < 2; repeatEnds++) {
+					build(arp, nPitches, repeatEnds, sequences[arp][nPitches][repeatEnds]);
+				}
+			}
+		}
+		for (unsigned int arp = 0; arp < NUM_ARPS; arp++) {
+			sequences[arp][0][0] = sequences[arp][0][1] = sequences[arp][1][0];
+		}
 	}
-	
-	bool isArpeggioFinished() {
-		// std::cout << "FIN " << index << " " << nPitches << std::endl;
-		return (index >= nPitches - 1);
+
+	void build(unsigned int arp, unsigned int nPitches, bool repeatEnds, Sequence &seq) {
+		switch(arp) {
+			case 0:	buildRight(nPitches, seq);						break;
+			case 1:	buildLeft(nPitches, seq);						break;
+			case 2:	buildRightLeft(nPitches, repeatEnds, seq);		break;
+			case 3:	buildLeftRight(nPitches, repeatEnds, seq);		break;
+			case 4:	buildCrabRight(nPitches, seq);					break;
+			case 5:	buildCrabLeft(nPitches, seq);					break;
+			case 6:	buildCrabRightLeft(nPitches, repeatEnds, seq);	break;
+			case 7:	buildCrabLeftRight(nPitches, repeatEnds, seq);	break;
+			default: buildRight(nPitches, seq);						break;
+		}
 	}
 
 	// For RL and LR arps we have the following logic
@@ -83,156 +77,47 @@ struct Arpeggio2 {
 	// 8 (2)
 	// 9 (END, do not repeat 1)
 
-};
-
-struct RightArp2 : Arpeggio2 {
-
-	const std::string name = "Straight-R";
-
-	const std::string & getName() override {
-		return name;
-	};
-
-	void initialise(unsigned int _np, unsigned int _offset, bool _repeatEnds) override {
-
-		Arpeggio2::initialise(_np, _offset, _repeatEnds);
-
-		// std::cout << name;
-		// std::cout << " DEF ";
-		indexes.clear();
-
+	void buildRight(unsigned int nPitches, Sequence &seq) {
 		for (unsigned int i = 0; i < nPitches; i++) {
-			// std::cout << i;
-			indexes.push_back(i);
+			seq.push(i);
 		}
-
-		nPitches = indexes.size();
-		offset = offset % nPitches;
-		index = offset;
-		// std::cout << " NP=" << nPitches << " -> " << index << std::endl;
-
 	}
-		
-};
-
-struct LeftArp2 : Arpeggio2 {
-
-	const std::string name = "Straight-L";
-
-	const std::string & getName() override {
-		return name;
-	};
-	
-	void initialise(unsigned int _np, unsigned int _offset, bool _repeatEnds) override {
-
-		Arpeggio2::initialise(_np, _offset, _repeatEnds);
-
-		// std::cout << name;
-		// std::cout << " DEF ";
-		indexes.clear();
 
+	void buildLeft(unsigned int nPitches, Sequence &seq) {
 		for (int i = nPitches - 1; i >= 0; i--) {
-			// std::cout << i;
-			indexes.push_back(i);
+			seq.push(i);
 		}
-
-		nPitches = indexes.size();
-		offset = offset % nPitches;
-		index = offset;
-		// std::cout << " NP=" << nPitches << " -> " << index << std::endl;
-
 	}
-		
-};
 
-struct RightLeftArp2 : Arpeggio2 {
-
-	const std::string name = "Straight-RL";
-	
-	const std::string & getName() override {
-		return name;
-	};
-
-	void initialise(unsigned int _np, unsigned int _offset, bool _repeatEnds) override {
-
-		Arpeggio2::initialise(_np, _offset, _repeatEnds);
-		// std::cout << name;
-		// std::cout << " DEF ";
-		indexes.clear();
+	void buildRightLeft(unsigned int nPitches, bool repeatEnds, Sequence &seq) {
 
 		for (unsigned int i = 0; i < nPitches; i++) {
-			// std::cout << i;
-			indexes.push_back(i);
+			seq.push(i);
 		}
 
 		int end = repeatEnds ? 0 : 1;
 
 		for (int i = nPitches - 2; i >= end; i--) {
-			// std::cout << i;
-			indexes.push_back(i);
+			seq.push(i);
 		}
 
-		nPitches = indexes.size();
-		offset = offset % nPitches;
-		index = offset;
-		// std::cout << " NP=" << nPitches << " -> " << index << std::endl;
-
 	}
-		
-};
 
-struct LeftRightArp2 : Arpeggio2 {
-
-	const std::string name = "Straight-LR";
-	
-	const std::string & getName() override {
-		return name;
-	};
-
-	void initialise(unsigned int _np, unsigned int _offset, bool _repeatEnds) override {
-
-		Arpeggio2::initialise(_np, _offset, _repeatEnds);
-
-		// std::cout << name;
-		// std::cout << " DEF ";
-		indexes.clear();
+	void buildLeftRight(unsigned int nPitches, bool repeatEnds, Sequence &seq) {
 
 		for (int i = nPitches - 1; i >= 0; i--) {
-			// std::cout << i;
-			indexes.push_back(i);
+			seq.push(i);
 		}
 
 		int end = repeatEnds ? 0 : 1;
 
 		for (unsigned int i = 1; i < nPitches - end; i++) {
-			// std::cout << i;
-			indexes.push_back(i);
+			seq.push(i);
 		}
 
-		nPitches = indexes.size();
-		offset = offset % nPitches;
-		index = offset;
-		// std::cout << " NP=" << nPitches << " -> " << index << std::endl;
-
 	}
-		
-};
-
-struct CrabRightArp2 : Arpeggio2 {
-
-	const std::string name = "Crab-R";
-	
-	const std::string & getName() override {
-		return name;
-	};
-
-	void initialise(unsigned int _np, unsigned int _offset, bool _repeatEnds) override {
-
-		Arpeggio2::initialise(_np, _offset, _repeatEnds);
 
-		// std::cout << name;
-		// std::cout << " DEF ";
-		indexes.clear();
+	void buildCrabRight(unsigned int nPitches, Sequence &seq) {
 
 		int steps[2] = {2, -1};
 
@@ -244,51 +129,28 @@ struct CrabRightArp2 : Arpeggio2 {
 		// 6 = 8: 0, 2, 1, 3, 2, 4, 3, 5
 
 		if (nPitches == 1) {
-			indexes.push_back(0);
+			seq.push(0);
 		} else if (nPitches == 2) {
-			indexes.push_back(0);
-			indexes.push_back(0);
+			seq.push(0);
+			seq.push(0);
 		} else {
 			unsigned int p = 0;
 			unsigned int i = 0;
 
 			while (true) {
-				// std::cout << p;
-				indexes.push_back(p);
+				seq.push(p);
 				p = p + steps[i % 2];
 				i++;
 				if (p == nPitches - 1) {
-					// std::cout << p;
-					indexes.push_back(p);
+					seq.push(p);
 					break;
 				}
 			} 
 		}
 
-		nPitches = indexes.size();
-		offset = offset % nPitches;
-		index = offset;
-		// std::cout << " NP=" << nPitches << " -> " << index << std::endl;
-
 	}
-		
-};
 
-struct CrabLeftArp2 : Arpeggio2 {
-
-	const std::string name = "Crab-L";
-	
-	const std::string & getName() override {
-		return name;
-	};
-
-	void initialise(unsigned int _np, unsigned int _offset, bool _repeatEnds) override {
-
-		Arpeggio2::initialise(_np, _offset, _repeatEnds);
-
-		// std::cout << name;
-		// std::cout << " DEF ";
-		indexes.clear();
+	void buildCrabLeft(unsigned int nPitches, Sequence &seq) {
 
 		int steps[2] = {-2, 1};
 
@@ -300,51 +162,28 @@ struct CrabLeftArp2 : Arpeggio2 {
 		// 6 = 8: 5, 3, 4, 2, 3, 1, 2, 0
 
 		if (nPitches == 1) {
-			indexes.push_back(nPitches - 1);
+			seq.push(nPitches - 1);
 		} else if (nPitches == 2) {
-			indexes.push_back(nPitches - 1);
-			indexes.push_back(nPitches - 1);
+			seq.push(nPitches - 1);
+			seq.push(nPitches - 1);
 		} else {
 			unsigned int p = nPitches - 1;
 			unsigned int i = 0;
 
 			while (true) {
-				// std::cout << p;
-				indexes.push_back(p);
+				seq.push(p);
 				p = p + steps[i % 2];
 				i++;
 				if (p == 0) {
-					// std::cout << p;
-					indexes.push_back(0);
+					seq.push(0);
 					break;
 				}
 			} 
 		}
 
-		nPitches = indexes.size();
-		offset = offset % nPitches;
-		index = offset;
-		// std::cout << " NP=" << nPitches << " -> " << index << std::endl;
-
 	}
-		
-};
 
-struct CrabRightLeftArp2 : Arpeggio2 {
-
-	const std::string name = "Crab-RL";
-	
-	const std::string & getName() override {
-		return name;
-	};
-
-	void initialise(unsigned int _np, unsigned int _offset, bool _repeatEnds) override {
-
-		Arpeggio2::initialise(_np, _offset, _repeatEnds);
-
-		// std::cout << name;
-		// std::cout << " DEF ";
-		indexes.clear();
+	void buildCrabRightLeft(unsigned int nPitches, bool repeatEnds, Sequence &seq) {
 
 		int stepsR[2] = {2, -1};
 		int stepsL[2] = {-2, 1};
@@ -360,23 +199,29 @@ struct CrabRightLeftArp2 : Arpeggio2 {
 		// 0213243534231
 
 		if (nPitches == 1) {
-			indexes.push_back(0);
+			seq.push(0);
 		} else if (nPitches == 2) {
-			indexes.push_back(0);
-			indexes.push_back(0);
+			seq.push(0);
+			seq.push(0);
+		} else if (nPitches == 3) { // The walk back would step past the first pitch
+			seq.push(0);
+			seq.push(2);
+			seq.push(1);
+			seq.push(2);
+			if (repeatEnds) {
+				seq.push(0);
+			}
 		} else {
 
 			unsigned int p = 0;
 			unsigned int i = 0;
 
 			while (true) {
-				// std::cout << p;
-				indexes.push_back(p);
+				seq.push(p);
 				p = p + stepsR[i % 2];
 				i++;
 				if (p == nPitches - 1) {
-					// std::cout << p;
-					indexes.push_back(p);
+					seq.push(p);
 					break;
 				}
 			} 
@@ -386,42 +231,19 @@ struct CrabRightLeftArp2 : Arpeggio2 {
 			unsigned int end = repeatEnds ? 0 : 1;
 
 			while (true) {
-				// std::cout << p;
-				indexes.push_back(p);
+				seq.push(p);
 				p = p + stepsL[i % 2];
 				i++;
 				if (p == end) {
-					// std::cout << end;
-					indexes.push_back(end);
+					seq.push(end);
 					break;
 				}
 			} 
 		}
 
-		nPitches = indexes.size();
-		offset = offset % nPitches;
-		index = offset;
-		// std::cout << " NP=" << nPitches << " -> " << index << std::endl;
-
 	}
-		
-};
-
-struct CrabLeftRightArp2 : Arpeggio2 {
-
-	const std::string name = "Crab-LR";
-	
-	const std::string & getName() override {
-		return name;
-	};
-
-	void initialise(unsigned int _np, unsigned int _offset, bool _repeatEnds) override {
 
-		Arpeggio2::initialise(_np, _offset, _repeatEnds);
-
-		// std::cout << name;
-		// std::cout << " DEF ";
-		indexes.clear();
+	void buildCrabLeftRight(unsigned int nPitches, bool repeatEnds, Sequence &seq) {
 
 		int stepsR[2] = {2, -1};
 		int stepsL[2] = {-2, 1};
@@ -437,23 +259,29 @@ struct CrabLeftRightArp2 : Arpeggio2 {
 		// 534231202132435
 
 		if (nPitches == 1) {
-			indexes.push_back(nPitches - 1);
+			seq.push(nPitches - 1);
 		} else if (nPitches == 2) {
-			indexes.push_back(nPitches - 1);
-			indexes.push_back(nPitches - 1);
+			seq.push(nPitches - 1);
+			seq.push(nPitches - 1);
+		} else if (nPitches == 3) { // The walk back would step past the last pitch
+			seq.push(2);
+			seq.push(0);
+			seq.push(1);
+			seq.push(0);
+			if (repeatEnds) {
+				seq.push(2);
+			}
 		} else {
 
 			unsigned int p = nPitches - 1;
 			unsigned int i = 0;
 
 			while (true) {
-				// std::cout << p;
-				indexes.push_back(p);
+				seq.push(p);
 				p = p + stepsL[i % 2];
 				i++;
 				if (p == 0) {
-					// std::cout << p;
-					indexes.push_back(0);
+					seq.push(0);
 					break;
 				}
 			} 
@@ -463,25 +291,89 @@ struct CrabLeftRightArp2 : Arpeggio2 {
 			unsigned int end = repeatEnds ? 0 : 1;
 
 			while (true) {
-				// std::cout << p;
-				indexes.push_back(p);
+				seq.push(p);
 				p = p + stepsR[i % 2];
 				i++;
 				if (p == nPitches - 1 - end) {
-					// std::cout << p;
-					indexes.push_back(p);
+					seq.push(p);
 					break;
 				}
 			} 
 		}
 
-		nPitches = indexes.size();
-		offset = offset % nPitches;
+	}
+
+};
+
+// The position of one lane in its arpeggio. The sequence is shared until the lane is randomised, when it takes a
+// private copy to permute
+struct Arpeggio2 {
+
+	const Arpeggio2Tables &tables = Arpeggio2Tables::get();
+
+	const unsigned char *indexes;
+	unsigned char shuffled[Arpeggio2Tables::MAX_LENGTH];
+
+	unsigned int arp = 0;
+	unsigned int index = 0;
+	unsigned int offset = 0;	
+	unsigned int nPitches = 0;
+
+	Arpeggio2() {
+		initialise(0, 1, 0, false);
+	}
+
+	const std::string & getName() {
+		return tables.names[arp];
+	}
+
+	void initialise(unsigned int _arp, unsigned int _nPitches, unsigned int _offset, bool _repeatEnds) {
+		arp = std::min(_arp, Arpeggio2Tables::NUM_ARPS - 1);
+		const Arpeggio2Tables::Sequence &seq = tables.sequences[arp][std::min(_nPitches, Arpeggio2Tables::MAX_PITCHES)][_repeatEnds];
+		indexes = seq.indexes;
+		nPitches = seq.length;
+		offset = _offset % nPitches;
 		index = offset;
-		// std::cout << " NP=" << nPitches << " -> " << index << std::endl;
+	}
+	
+	void advance() {
+		index++;
+	}
 
+	void reset() {
+		index = offset;
 	}
-		
+
+	void randomize(ah::core::Random &rng) {
+		int length = nPitches - offset;
+		int p1 = rng.integer(length) + offset;
+		int p2 = rng.integer(length) + offset;
+		int tries = 0;
+
+		while (p1 == p2 && tries < 5) { // Make some effort to change the sequence, break after 5 attempts
+			p2 = rng.integer(length) + offset;
+			tries++;
+		}
+
+		if (indexes != shuffled) {
+			std::memcpy(shuffled, indexes, nPitches);
+			indexes = shuffled;
+		}
+
+		unsigned char t = shuffled[p1];
+		shuffled[p1] = shuffled[p2];
+		shuffled[p2] = t;
+
+	}
+
+	unsigned int getPitch() {
+		return indexes[index];
+	}
+	
+	bool isArpeggioFinished() {
+		return (index >= nPitches - 1);
+	}
+
 };
 
 using namespace ah;
@@ -490,6 +382,8 @@ struct Arp31 : core::AHModule {
 	
 	const static int MAX_STEPS = 16;
 	const static int MAX_DIST = 12; //Octave
+	const static int MAX_LANES = 16;
+	const static int MAX_PITCHES = 16;
 
 	enum ParamIds {
 		ARP_PARAM,
@@ -532,25 +426,17 @@ struct Arp31 : core::AHModule {
 		configOutput(GATE_OUTPUT, "Trigger: On pitch change");
 		configOutput(EOC_OUTPUT, "Trigger: On end of arpeggio");
 
-		arps.push_back(&arp_right);
-		arps.push_back(&arp_left);
-		arps.push_back(&arp_rightleft);
-		arps.push_back(&arp_leftright);
-		arps.push_back(&arp_crabright);
-		arps.push_back(&arp_crableft);
-		arps.push_back(&arp_crabrightleft);
-		arps.push_back(&arp_crableftright);
-		nextArp = arps[0]->getName();
-
 		onReset();
-		id = rand();
+		id = rng.next();
         debugFlag = false;
 	}
 
 	void process(const ProcessArgs &args) override;
 	
 	void onReset() override {
-		isRunning = false;
+		for (int l = 0; l < MAX_LANES; l++) {
+			isRunning[l] = false;
+		}
 	}
 	
 	json_t *dataToJson() override {
@@ -564,6 +450,9 @@ struct Arp31 : core::AHModule {
 		json_t *repeatModeJ = json_boolean((bool) repeatEnd);
 		json_object_set_new(rootJ, "repeatMode", repeatModeJ);
 
+		// multiLane
+		json_object_set_new(rootJ, "multiLane", json_boolean(multiLane));
+
 		return rootJ;
 	}
 	
@@ -576,7 +465,21 @@ struct Arp31 : core::AHModule {
 		json_t *repeatModeJ = json_object_get(rootJ, "repeatMode");
 		if (repeatModeJ) repeatEnd = json_boolean_value(repeatModeJ);
 
+		// multiLane
+		json_t *multiLaneJ = json_object_get(rootJ, "multiLane");
+		if (multiLaneJ) multiLane = json_boolean_value(multiLaneJ);
+
 	}
+
+	// In multi-lane mode each CLOCK channel runs its own arpeggio over the chord on PITCH/GATE
+	int getLanes() {
+		if (!multiLane) {
+			return 1;
+		}
+		return clamp(inputs[CLOCK_INPUT].getChannels(), 1, MAX_LANES);
+	}
+
+	void readPitches(int lane);
 	
 	enum GateMode {
 		TRIGGER,
@@ -585,38 +488,56 @@ struct Arp31 : core::AHModule {
 	};
 	GateMode gateMode = TRIGGER;
 	
-	rack::dsp::SchmittTrigger clockTrigger; // for clock
-	rack::dsp::SchmittTrigger randomTrigger; // for random
+	// Triggers and pulses for four lanes at a time
+	rack::dsp::TSchmittTrigger<simd::float_4> clockTrigger[MAX_LANES / 4]; // for clock
+	rack::dsp::TSchmittTrigger<simd::float_4> randomTrigger[MAX_LANES / 4]; // for random
 	
-	rack::dsp::PulseGenerator gatePulse;
-	rack::dsp::PulseGenerator eocPulse;
+	digital::AHPulseGenerator4 gatePulse[MAX_LANES / 4];
+	digital::AHPulseGenerator4 eocPulse[MAX_LANES / 4];
 
 	int id = 0;
 	int currLight = 0;
-	float outVolts = 0;
-	bool isRunning = false;
-	unsigned int inputArp = 0;
-	bool eoc = false;
 	bool repeatEnd = false;
+	bool multiLane = false;
 
-	std::vector<Arpeggio2 *> arps;
+	// Lane state
+	float outVolts[MAX_LANES] = {};
+	bool isRunning[MAX_LANES] = {};
+	bool eoc[MAX_LANES] = {};
 
-	RightArp2 			arp_right;
-	LeftArp2 			arp_left;
-	RightLeftArp2 		arp_rightleft;
-	LeftRightArp2 		arp_leftright;
-	CrabRightArp2 		arp_crabright;
-	CrabLeftArp2 		arp_crableft;
-	CrabRightLeftArp2	arp_crabrightleft;
-	CrabLeftRightArp2	arp_crableftright;
+	float pitches[MAX_LANES][MAX_PITCHES];
+	unsigned int nPitches[MAX_LANES] = {};
 
-	Arpeggio2 *currArp = &arp_right;
-	
-	std::vector<float> pitches;
-	std::string nextArp;
+	Arpeggio2 arps[MAX_LANES];
+
+	unsigned int nextArp = 0; // Index into arps for the display, from lane 0
 
 };
 
+void Arp31::readPitches(int lane) {
+
+	// Read input pitches and assign to pitch array
+	nPitches[lane] = 0;
+	if (inputs[PITCH_INPUT].isConnected()) {
+		int channels = inputs[PITCH_INPUT].getChannels();
+		if (debugEnabled()) { std::cout << stepX << " " << id  << " Channels: " << channels << std::endl; }
+
+		if (inputs[GATE_INPUT].isConnected()) {
+			for (int p = 0; p < channels; p++) {
+				if (inputs[GATE_INPUT].getVoltage(p) > 0.0f) {
+					pitches[lane][nPitches[lane]++] = inputs[PITCH_INPUT].getVoltage(p);
+				}
+			}
+		} else { // No gate info, read sequentially;
+			for (int p = 0; p < channels; p++) {
+				pitches[lane][nPitches[lane]++] = inputs[PITCH_INPUT].getVoltage(p);
+			}
+		}
+
+	} 
+
+}
+
 void Arp31::process(const ProcessArgs &args) {
 	
 	AHModule::step();
@@ -626,168 +547,185 @@ void Arp31::process(const ProcessArgs &args) {
 		return;
 	}
 	
+	int lanes = getLanes();
+	int nGroups = (lanes + 3) / 4;
+	int laneBits = (1 << lanes) - 1;
+
 	// Get inputs from Rack
-	float clockInput	= inputs[CLOCK_INPUT].getVoltage();
 	bool  clockActive	= inputs[CLOCK_INPUT].isConnected();
-	float randomInput	= inputs[RANDOM_INPUT].getVoltage();
-
-	if (inputs[ARP_INPUT].isConnected()) {
-		inputArp = clamp(static_cast<unsigned int>(inputs[ARP_INPUT].getVoltage()), 0, 7);
-	} else {
-		inputArp = params[ARP_PARAM].getValue();
-	}	
-
 	size_t offset = params[OFFSET_PARAM].getValue();
-	int hold = digital::sgn(inputs[HOLD_INPUT].getVoltage(), 0.001);
 
-	// Process inputs
-	bool clockStatus = clockTrigger.process(clockInput);
-	bool randomStatus = randomTrigger.process(randomInput);
-	
-	// If there is no clock input, then force that we are not running
-	if (!clockActive) {
-		isRunning = false;
+	// Process inputs, all lanes together
+	int clockStatus = 0;
+	int randomStatus = 0;
+	for (int g = 0; g < nGroups; g++) {
+		simd::float_4 clockInput = inputs[CLOCK_INPUT].getPolyVoltageSimd<simd::float_4>(g * 4);
+		simd::float_4 randomInput = inputs[RANDOM_INPUT].getPolyVoltageSimd<simd::float_4>(g * 4);
+		clockStatus |= simd::movemask(clockTrigger[g].process(clockInput)) << (g * 4);
+		randomStatus |= simd::movemask(randomTrigger[g].process(randomInput)) << (g * 4);
 	}
+	clockStatus &= laneBits;
+	randomStatus &= laneBits;
 
-	bool restart = false;
+	int gates = 0;
+	int eocs = 0;
 
-	if (debugEnabled()) { std::cout << stepX << " " << id  << " Check clock" << std::endl; }
+	for (int l = 0; l < lanes; l++) {
 
-	// Have we been clocked?
-	if (clockStatus) {
+		unsigned int inputArp;
+		if (inputs[ARP_INPUT].isConnected()) {
+			inputArp = clamp(static_cast<unsigned int>(inputs[ARP_INPUT].getPolyVoltage(l)), 0, 7);
+		} else {
+			inputArp = params[ARP_PARAM].getValue();
+		}	
 
-		if (debugEnabled()) { std::cout << stepX << " " << id  << " Check EOC" << std::endl; }
+		if (l == 0) {
+			nextArp = inputArp;
+		}
 
-		// EOC was fired at last sequence step
-		if (eoc) {
-			if (debugEnabled()) { std::cout << stepX << " " << id  << " EOC fired" << std::endl; }
-			eocPulse.trigger(digital::TRIGGER);
-			eoc = false;
-		}	
+		int hold = digital::sgn(inputs[HOLD_INPUT].getPolyVoltage(l), 0.001);
 
-		// If we are already running, process cycle
-		if (isRunning) {
+		// If there is no clock input, then force that we are not running
+		if (!clockActive) {
+			isRunning[l] = false;
+		}
 
-			if (debugEnabled()) { std::cout << stepX << " " << id  << " Advance Cycle: " << currArp->getPitch() << " " << pitches[currArp->getPitch()] << std::endl; }
+		bool restart = false;
 
-			// Reached the end of the pattern?
-			if (currArp->isArpeggioFinished()) {
+		if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Check clock" << std::endl; }
 
-				// Trigger EOC mechanism
-				eoc = true;
+		// Have we been clocked?
+		if ((clockStatus >> l) & 1) {
 
-				if (debugEnabled()) { std::cout << stepX << " " << id  << " Finished Cycle" << std::endl; }
-				restart = true;
+			if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Check EOC" << std::endl; }
 
-			} 
+			// EOC was fired at last sequence step
+			if (eoc[l]) {
+				if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " EOC fired" << std::endl; }
+				eocs |= 1 << l;
+				eoc[l] = false;
+			}	
 
-			// Finally set the out voltage
-			size_t idx = currArp->getPitch();
-			outVolts = clamp(pitches[idx], -10.0f, 10.0f);
+			// If we are already running, process cycle
+			if (isRunning[l]) {
 
-			if (debugEnabled()) { std::cout << stepX << " " << id  << " Index: " << idx << " V: " << outVolts << " Light: " << currLight << std::endl; }
+				Arpeggio2 *arp = &arps[l];
 
-			// Pulse the output gate
-			gatePulse.trigger(digital::TRIGGER);
+				if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Advance Cycle: " << arp->getPitch() << " " << pitches[l][arp->getPitch()] << std::endl; }
 
-			// Completed 1 step
-			currArp->advance();
+				// Reached the end of the pattern?
+				if (arp->isArpeggioFinished()) {
 
-		} else {
+					// Trigger EOC mechanism
+					eoc[l] = true;
+
+					if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Finished Cycle" << std::endl; }
+					restart = true;
+
+				} 
+
+				// Finally set the out voltage
+				size_t idx = arp->getPitch();
+				outVolts[l] = clamp(pitches[l][idx], -10.0f, 10.0f);
+
+				if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Index: " << idx << " V: " << outVolts[l] << " Light: " << currLight << std::endl; }
 
-			// Start a cycle
-			restart = true;
+				// Pulse the output gate
+				gates |= 1 << l;
+
+				// Completed 1 step
+				arp->advance();
+
+			} else {
+
+				// Start a cycle
+				restart = true;
+
+			}
 
 		}
 
-	}
+		// Randomise if triggered
+		if (((randomStatus >> l) & 1) && isRunning[l] && hold != -1) {
+			arps[l].randomize(rng);
+		}
 
-	// Randomise if triggered
-	if (randomStatus && isRunning && hold != -1) {
-		currArp->randomize();
-	}
+		if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Check restart" << std::endl; }
+
+		// If we have been triggered, start a new sequence
+		if (restart) {
+
+			if (!hold) {
+
+				readPitches(l);
 
-	if (debugEnabled()) { std::cout << stepX << " " << id  << " Check restart" << std::endl; }
-
-	// If we have been triggered, start a new sequence
-	if (restart) {
-
-		if (!hold) {
-
-			// Read input pitches and assign to pitch array
-			pitches.clear();
-			if (inputs[PITCH_INPUT].isConnected()) {
-				int channels = inputs[PITCH_INPUT].getChannels();
-				if (debugEnabled()) { std::cout << stepX << " " << id  << " Channels: " << channels << std::endl; }
-
-				if (inputs[GATE_INPUT].isConnected()) {
-					for (int p = 0; p < channels; p++) {
-						if (inputs[GATE_INPUT].getVoltage(p) > 0.0f) {
-							pitches.push_back(inputs[PITCH_INPUT].getVoltage(p));
-						}
-					}
-				} else { // No gate info, read sequentially;
-					for (int p = 0; p < channels; p++) {
-						pitches.push_back(inputs[PITCH_INPUT].getVoltage(p));
-					}
+				if (nPitches[l] == 0) {
+					if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " No inputs, assume single 0V pitch" << std::endl; }
+					pitches[l][0] = 0.0f;
+					nPitches[l] = 1;
 				}
 
-			} 
+				if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Pitches: " << nPitches[l] << std::endl; }
 
-			if (pitches.size() == 0) {
-				if (debugEnabled()) { std::cout << stepX << " " << id  << " No inputs, assume single 0V pitch" << std::endl; }
-				pitches.push_back(0.0f);
-			}
+				// At the first step of the cycle
+				// So this is where we tweak the cycle parameters
+				arps[l].initialise(inputArp, nPitches[l], offset, repeatEnd);
 
-			if (debugEnabled()) { std::cout << stepX << " " << id  << " Pitches: " << pitches.size() << std::endl; }
+				if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Initiatise new Cycle: Pattern: " << arps[l].getName() << " nPitches: " << nPitches[l] << std::endl; }
 
-			// At the first step of the cycle
-			// So this is where we tweak the cycle parameters
-			currArp = arps[inputArp];
+			} else {
 
-			if (debugEnabled()) { std::cout << stepX << " " << id  << " Initiatise new Cycle: Pattern: " << currArp->getName() << " nPitches: " << pitches.size() << std::endl; }
-			
-			currArp->initialise(pitches.size(), offset, repeatEnd);
+				if (nPitches[l] == 0) {
+					if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " No inputs, assume single 0V pitch" << std::endl; }
+					pitches[l][0] = 0.0f;
+					nPitches[l] = 1;
+				}
 
-		} else {
+				if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Hold Cycle: Pattern: " << arps[l].getName() << " nPitches: " << nPitches[l] << std::endl; }
+
+				arps[l].reset();
 
-			if (pitches.size() == 0) {
-				if (debugEnabled()) { std::cout << stepX << " " << id  << " No inputs, assume single 0V pitch" << std::endl; }
-				pitches.push_back(0.0f);
 			}
 
-			if (debugEnabled()) { std::cout << stepX << " " << id  << " Hold Cycle: Pattern: " << currArp->getName() << " nPitches: " << pitches.size() << std::endl; }
+			// Start
+			isRunning[l] = true;
+			
+		} 
 
-			currArp->reset();
+	}
 
-		}
+	if (debugEnabled()) { std::cout << stepX << " " << id  << " Do gate status" << std::endl; }
 
-		// Start
-		isRunning = true;
-		
-	} 
+	for (int g = 0; g < nGroups; g++) {
 
-	nextArp = arps[inputArp]->getName();
+		int runningBits = 0;
+		for (int j = 0; j < 4 && g * 4 + j < lanes; j++) {
+			runningBits |= isRunning[g * 4 + j] << j;
+		}
 
-	// Set the value
-	outputs[OUT_OUTPUT].setVoltage(outVolts);
+		gatePulse[g].trigger(digital::laneMask(gates >> (g * 4)), digital::TRIGGER);
+		eocPulse[g].trigger(digital::laneMask(eocs >> (g * 4)), digital::TRIGGER);
 
-	bool gPulse = gatePulse.process(args.sampleTime);
+		simd::float_4 gPulse = gatePulse[g].process(args.sampleTime);
+		simd::float_4 cPulse = eocPulse[g].process(args.sampleTime);
 
-	if (debugEnabled()) { std::cout << stepX << " " << id  << " Do gate status" << std::endl; }
+		simd::float_4 gatesOn = digital::laneMask(runningBits);
+		if (gateMode == TRIGGER) {
+			gatesOn = gatesOn & gPulse;
+		} else if (gateMode == RETRIGGER) {
+			gatesOn = gatesOn & ~gPulse;
+		}
+
+		// Set the value
+		outputs[OUT_OUTPUT].setVoltageSimd(simd::float_4::load(outVolts + g * 4), g * 4);
+		outputs[GATE_OUTPUT].setVoltageSimd(simd::ifelse(gatesOn, 10.0f, 0.0f), g * 4);
+		outputs[EOC_OUTPUT].setVoltageSimd(simd::ifelse(cPulse, 10.0f, 0.0f), g * 4);
 
-	bool gatesOn = isRunning;
-	if (gateMode == TRIGGER) {
-		gatesOn = gatesOn && gPulse;
-	} else if (gateMode == RETRIGGER) {
-		gatesOn = gatesOn && !gPulse;
 	}
-	if (debugEnabled()) { std::cout << stepX << " " << id  << " Checked gate status" << std::endl; }
-	
-	bool cPulse = eocPulse.process(args.sampleTime);
 
-	outputs[GATE_OUTPUT].setVoltage(gatesOn ? 10.0 : 0.0);
-	outputs[EOC_OUTPUT].setVoltage(cPulse ? 10.0 : 0.0);
+	outputs[OUT_OUTPUT].setChannels(lanes);
+	outputs[GATE_OUTPUT].setChannels(lanes);
+	outputs[EOC_OUTPUT].setChannels(lanes);
 
 	if (debugEnabled()) { std::cout << stepX << " " << id  << " Finish output phase" << std::endl; }
 
@@ -820,7 +758,7 @@ struct Arp31Display : TransparentWidget {
 			nvgFillColor(ctx.vg, nvgRGBA(0x00, 0xFF, 0xFF, 0xFF));
 		
 			char text[128];
-			snprintf(text, sizeof(text), "%s", module->nextArp.c_str());
+			snprintf(text, sizeof(text), "%s", Arpeggio2Tables::get().names[module->nextArp].c_str());
 			nvgText(ctx.vg, pos.x, pos.y, text, NULL);
 		}		
 	}
@@ -831,6 +769,7 @@ struct Arp31Widget : ModuleWidget {
 
 	std::vector<MenuOption<Arp31::GateMode>> gateOptions;
 	std::vector<MenuOption<bool>> noteOptions;
+	std::vector<MenuOption<bool>> laneOptions;
 
 	Arp31Widget(Arp31 *module) {
 	
@@ -865,6 +804,9 @@ struct Arp31Widget : ModuleWidget {
 		noteOptions.emplace_back(std::string("Omit last note"), false);
 		noteOptions.emplace_back(std::string("Play last note"), true);
 
+		laneOptions.emplace_back(std::string("Off"), false);
+		laneOptions.emplace_back(std::string("One arpeggio per clock channel"), true);
+
 	}
 
 	void appendContextMenu(Menu *menu) override {
@@ -917,6 +859,26 @@ struct Arp31Widget : ModuleWidget {
 			}
 		};
 
+		struct LaneModeItem : Arp31Menu {
+			bool multiLane;
+			void onAction(const rack::event::Action &e) override {
+				module->multiLane = multiLane;
+			}
+		};
+
+		struct LaneModeMenu : Arp31Menu {
+			Menu *createChildMenu() override {
+				Menu *menu = new Menu;
+				for (auto opt: parent->laneOptions) {
+					LaneModeItem *item = createMenuItem<LaneModeItem>(opt.name, CHECKMARK(module->multiLane == opt.value));
+					item->module = module;
+					item->multiLane = opt.value;
+					menu->addChild(item);
+				}
+				return menu;
+			}
+		};
+
 		menu->addChild(construct<MenuLabel>());
 		GateModeMenu *gitem = createMenuItem<GateModeMenu>("Gate Mode");
 		gitem->module = arp;
@@ -928,6 +890,13 @@ struct Arp31Widget : ModuleWidget {
 		ritem->parent = this;
 		menu->addChild(ritem);
 
+		LaneModeMenu *litem = createMenuItem<LaneModeMenu>("Multi-lane mode");
+		litem->module = arp;
+		litem->parent = this;
+		menu->addChild(litem);
+
+		menu->addChild(gui::createFixedSeedItem(arp));
+
      }
 	 
 };
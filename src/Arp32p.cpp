@@ -1,364 +1,26 @@
 #include "AH.hpp"
 #include "AHCommon.hpp"
+#include "dsp/arpeggio.hpp"
 
 #include <iostream>
 
 using namespace ah;
 
-struct Pattern2 {
-	
-	std::vector<int> notes;
-	unsigned int nNotes = 0;
-
-	unsigned int patternLength = 0;
-	int stepSize = 0;
-	unsigned int stepScale = 0;
-	unsigned int patternOffset = 0;
-	bool repeatLast = false;
-
-	unsigned int index = 0;
-
-	unsigned int MAJOR[7] = {0,2,4,5,7,9,11};
-	unsigned int MINOR[7] = {0,2,3,5,7,8,10};
-		
-	virtual const std::string & getName() = 0;
-
-	virtual void initialise(unsigned int _length, unsigned int _scale, int _size, unsigned int _offset, bool _repeat) {
-		patternLength = _length;
-		stepSize = _size;
-		stepScale = _scale;
-		patternOffset = _offset;
-		repeatLast = _repeat;
-	};
-
-	void advance() {
-		// std::cout << "ADV " << index << std::endl;
-		index++;
-	};
-
-	void reset() {
-		// std::cout << "RES" << std::endl;
-		index = patternOffset;
-	}
-
-	int getOffset() {
-		// std::cout << "OUT " << index << " " << notes[index] << std::endl;
-		return notes[index];
-	}
-
-	bool isPatternFinished() {
-		// std::cout << "FIN " << index << " " << nNotes << std::endl;
-		return (index >= nNotes - 1); 
-	}
-
-	int getMajor(int count) {
-		int i = abs(count);
-		int sign = (count < 0) ? -1 : (count > 0);
-		return sign * ((i / 7) * 12 + MAJOR[i % 7]);
-	}
-
-	int getMinor(int count) {
-		int i = abs(count);
-		int sign = (count < 0) ? -1 : (count > 0);
-		return sign * ((i / 7) * 12 + MINOR[i % 7]);
-	}
-
-	void randomize() {
-		int length = nNotes - patternOffset;
-		int p1 = (rand() % length) + patternOffset;
-		int p2 = (rand() % length) + patternOffset;
-		int tries = 0;
-
-		while (p1 == p2 && tries < 5) { // Make some effort to change the sequence, break after 5 attempts
-			p2 = (rand() % length) + patternOffset;
-			tries++;
-		}
-
-		// std::cout << "RND " << length << " " << p1 << " " << p2 << " "; 
-
-		unsigned int t = notes[p1];
-		notes[p1] = notes[p2];
-		notes[p2] = t;
-
-		// for (int i = 0; i < nPitches; i++) {
-		// 	std::cout << indexes[i];
-		// }
-
-		// std::cout << std::endl;
-
-	}
-
-};
-
-struct DivergePattern2 : Pattern2 {
-
-	const std::string name = "Diverge";
-
-	const std::string & getName() override {
-		return name;
-	};
-
-	void initialise(unsigned int _length, unsigned int _scale, int _size, unsigned int _offset, bool _repeat) override {
-
-		Pattern2::initialise(_length, _scale, _size, _offset, _repeat);
-
-		// std::cout << name;
-		// std::cout << " DEF ";
-		notes.clear();
-
-		for (unsigned int i = 0; i < patternLength; i++) {
-			
-			int n;
-			switch(stepScale) {
-				case 0: n = i * stepSize; break;
-				case 1: n = getMajor(i * stepSize); break;
-				case 2: n = getMinor(i * stepSize); break;
-				default:
-					n = i * stepSize; break;
-			}
-
-			notes.push_back(n);
-			// std::cout << n << " ";
-
-		}
-
-		nNotes = notes.size();
-		patternOffset = patternOffset % nNotes;
-		index = patternOffset;
-		// std::cout << " NP=" << nNotes << " -> " << index << std::endl;
-
-	}
-
-};
-
-struct ConvergePattern2 : Pattern2 {
-
-	const std::string name = "Converge";
-
-	const std::string & getName() override {
-		return name;
-	};
-
-	void initialise(unsigned int _length, unsigned int _scale, int _size, unsigned int _offset, bool _repeat) override {
-
-		Pattern2::initialise(_length, _scale, _size, _offset, _repeat);
-
-		// std::cout << name;
-		// std::cout << " DEF ";
-		notes.clear();
-
-		for (int i = patternLength - 1; i >= 0; i--) {
-			
-			int n;
-			switch(stepScale) {
-				case 0: n = i * stepSize; break;
-				case 1: n = getMajor(i * stepSize); break;
-				case 2: n = getMinor(i * stepSize); break;
-				default:
-					n = i * stepSize; break;
-			}
-
-			notes.push_back(n);
-			// std::cout << n << " ";
-
-		}
-
-		nNotes = notes.size();
-		patternOffset = patternOffset % nNotes;
-		index = patternOffset;
-		// std::cout << " NP=" << nNotes << " -> " << index << std::endl;
-
-	}
-
-};
-
-struct ReturnPattern2 : Pattern2 {
-
-	const std::string name = "Return";
-
-	const std::string & getName() override {
-		return name;
-	};
-
-	void initialise(unsigned int _length, unsigned int _scale, int _size, unsigned int _offset, bool _repeat) override {
-
-		Pattern2::initialise(_length, _scale, _size, _offset, _repeat);
-
-		// std::cout << name;
-		// std::cout << " DEF ";
-		notes.clear();
-
-		for (unsigned int i = 0; i < patternLength; i++) {
-			
-			int n;
-			switch(stepScale) {
-				case 0: n = i * stepSize; break;
-				case 1: n = getMajor(i * stepSize); break;
-				case 2: n = getMinor(i * stepSize); break;
-				default:
-					n = i * stepSize; break;
-			}
-
-			notes.push_back(n);
-			// std::cout << n << " ";
-
-		}
-
-		int end = repeatLast ? 0 : 1;
-
-		for (int i = patternLength - 2; i >= end; i--) {
-			
-			int n;
-			switch(stepScale) {
-				case 0: n = i * stepSize; break;
-				case 1: n = getMajor(i * stepSize); break;
-				case 2: n = getMinor(i * stepSize); break;
-				default:
-					n = i * stepSize; break;
-			}
-
-			notes.push_back(n);
-			// std::cout << n << " ";
-		}
-
-		nNotes = notes.size();
-		patternOffset = patternOffset % nNotes;
-		index = patternOffset;
-		// std::cout << " NP=" << nNotes << " -> " << index << std::endl;
-
-	}
-
-};
-
-struct BouncePattern2 : Pattern2 {
-
-	const std::string name = "Bounce";
-
-	const std::string & getName() override {
-		return name;
-	};
-
-	void initialise(unsigned int _length, unsigned int _scale, int _size, unsigned int _offset, bool _repeat) override {
-
-		Pattern2::initialise(_length, _scale, _size, _offset, _repeat);
-
-		// std::cout << name;
-		// std::cout << " DEF ";
-		notes.clear();
-
-		for (int i = patternLength - 1; i >= 0; i--) {
-			
-			int n;
-			switch(stepScale) {
-				case 0: n = i * stepSize; break;
-				case 1: n = getMajor(i * stepSize); break;
-				case 2: n = getMinor(i * stepSize); break;
-				default:
-					n = i * stepSize; break;
-			}
-
-			notes.push_back(n);
-			// std::cout << n << " ";
-
-		}
-
-		int end = repeatLast ? 0 : 1;
-
-		for (unsigned int i = 1; i < patternLength - end; i++) {
-			
-			int n;
-			switch(stepScale) {
-				case 0: n = i * stepSize; break;
-				case 1: n = getMajor(i * stepSize); break;
-				case 2: n = getMinor(i * stepSize); break;
-				default:
-					n = i * stepSize; break;
-			}
-
-			notes.push_back(n);
-			// std::cout << n << " ";
-
-		}
-
-		nNotes = notes.size();
-		patternOffset = patternOffset % nNotes;
-		index = patternOffset;
-		// std::cout << " NP=" << nNotes << " -> " << index << std::endl;
-
-	}
-
-};
-
-struct NotePattern2 : Pattern2 {
-
-	void initialise(unsigned int _length, unsigned int _scale, int _size, unsigned int _offset, bool _repeat) override {
-
-		Pattern2::initialise(_length, _scale, _size, _offset, _repeat);
-
-		nNotes = notes.size();
-		patternOffset = patternOffset % nNotes;
-		index = patternOffset;
-
-	}
-
-};
-
-struct RezPattern2 : NotePattern2 {
-
-	const std::string name = "Rez";
-
-	const std::string & getName() override {
-		return name;
-	};
-
-	RezPattern2() {
-		notes.clear();
-		notes.push_back(0);
-		notes.push_back(12);
-		notes.push_back(0);
-		notes.push_back(0);
-		notes.push_back(8);
-		notes.push_back(0);
-		notes.push_back(0);
-		notes.push_back(3);		
-		notes.push_back(0);
-		notes.push_back(0);
-		notes.push_back(3);
-		notes.push_back(0);
-		notes.push_back(3);
-		notes.push_back(0);
-		notes.push_back(8);
-		notes.push_back(0);
-	}
-
-};
-
-struct OnTheRunPattern2 : NotePattern2 {
-	
-	const std::string name = "On The Run";
-
-	const std::string & getName() override {
-		return name;
-	};
-
-	OnTheRunPattern2() {
-		notes.clear();
-		notes.push_back(0);
-		notes.push_back(4);
-		notes.push_back(6);
-		notes.push_back(4);
-		notes.push_back(9);
-		notes.push_back(11);
-		notes.push_back(13);
-		notes.push_back(11);
-	}
-	
+// In PATT_PARAM order
+constexpr arp::Pattern PATTERNS[] = {
+	{"Diverge",		arp::RISE,			1},
+	{"Converge",	arp::FALL,			1},
+	{"Return",		arp::RISE_FALL,		1},
+	{"Bounce",		arp::FALL_RISE,		1},
+	{"Rez",			arp::REZ,			0},
+	{"On The Run",	arp::ON_THE_RUN,	0}
 };
 
 struct Arp32 : core::AHModule {
 
 	const static int MAX_STEPS = 16;
 	const static int MAX_DIST = 12; // Octave
+	const static int MAX_LANES = 16;
 
 	enum ParamIds {
 		PATT_PARAM,
@@ -415,24 +77,18 @@ struct Arp32 : core::AHModule {
 		configOutput(GATE_OUTPUT, "Trigger: On pitch change");
 		configOutput(EOC_OUTPUT, "Trigger: On end of pattern");
 
-		patterns.push_back(&patt_diverge);
-		patterns.push_back(&patt_converge);
-		patterns.push_back(&patt_return);
-		patterns.push_back(&patt_bounce);
-		patterns.push_back(&patt_rez);
-		patterns.push_back(&patt_ontherun);
-
-		nextPattern = patterns[0]->getName();
 
 		onReset();
-		id = rand();
+		id = rng.next();
 		debugFlag = false;
 	}
 
 	void process(const ProcessArgs &args) override;
 
 	void onReset() override {
-		isRunning = false;
+		for (int l = 0; l < MAX_LANES; l++) {
+			isRunning[l] = false;
+		}
 	}
 
 	json_t *dataToJson() override {
@@ -446,6 +102,9 @@ struct Arp32 : core::AHModule {
 		json_t *repeatModeJ = json_boolean((bool) repeatEnd);
 		json_object_set_new(rootJ, "repeatMode", repeatModeJ);
 
+		// multiLane
+		json_object_set_new(rootJ, "multiLane", json_boolean(multiLane));
+
 		return rootJ;
 	}
 
@@ -457,6 +116,18 @@ struct Arp32 : core::AHModule {
 		// repeatMode
 		json_t *repeatModeJ = json_object_get(rootJ, "repeatMode");
 		if (repeatModeJ) repeatEnd = json_boolean_value(repeatModeJ);
+
+		// multiLane
+		json_t *multiLaneJ = json_object_get(rootJ, "multiLane");
+		if (multiLaneJ) multiLane = json_boolean_value(multiLaneJ);
+	}
+
+	// In multi-lane mode each CLOCK or PITCH channel runs its own pattern
+	int getLanes() {
+		if (!multiLane) {
+			return 1;
+		}
+		return clamp(std::max(inputs[CLOCK_INPUT].getChannels(), inputs[PITCH_INPUT].getChannels()), 1, MAX_LANES);
 	}
 
 	enum GateMode {
@@ -466,41 +137,35 @@ struct Arp32 : core::AHModule {
 	};
 	GateMode gateMode = TRIGGER;
 
-	rack::dsp::SchmittTrigger clockTrigger; // for clock
-	rack::dsp::SchmittTrigger randomTrigger; // for random
+	// Triggers and pulses for four lanes at a time
+	rack::dsp::TSchmittTrigger<simd::float_4> clockTrigger[MAX_LANES / 4]; // for clock
+	rack::dsp::TSchmittTrigger<simd::float_4> randomTrigger[MAX_LANES / 4]; // for random
 
-	rack::dsp::PulseGenerator gatePulse;
-	rack::dsp::PulseGenerator eocPulse;
+	digital::AHPulseGenerator4 gatePulse[MAX_LANES / 4];
+	digital::AHPulseGenerator4 eocPulse[MAX_LANES / 4];
 
 	int id = 0;
-	float outVolts = 0;
-	float rootPitch = 0.0;
-	bool isRunning = false;
-	bool eoc = false;
 	bool repeatEnd = false;
+	bool multiLane = false;
+
+	// Lane state
+	float outVolts[MAX_LANES] = {};
+	float rootPitch[MAX_LANES] = {};
+	bool isRunning[MAX_LANES] = {};
+	bool eoc[MAX_LANES] = {};
+
+	arp::Sequence pattern[MAX_LANES];
+	unsigned int patternId[MAX_LANES] = {};
+
+	struct DisplayState {
+		unsigned int pattern;
+		unsigned int length;
+		int size;
+		unsigned int scale;
+		int offset;
+	};
 
-	unsigned int inputPat = 0;
-	unsigned int inputLen = 0;
-	int inputSize = 0;
-	unsigned int inputScale = 0;
-
-	int pattern = 0;
-	int length = 0;
-	float size = 0;
-	float scale = 0;
-	int offset = 0;
-
-	std::vector<Pattern2 *>patterns;
-
-	DivergePattern2			patt_diverge; 
-	ConvergePattern2 		patt_converge; 
-	ReturnPattern2 			patt_return;
-	BouncePattern2 			patt_bounce;
-	RezPattern2 			patt_rez;
-	OnTheRunPattern2		patt_ontherun;
-
-	Pattern2 *currPatt = &patt_diverge;
-	std::string nextPattern;
+	core::SnapshotBuffer<DisplayState> displayState;
 
 };
 
@@ -513,166 +178,204 @@ void Arp32::process(const ProcessArgs &args) {
 		return;
 	}
 
+	int lanes = getLanes();
+	int nGroups = (lanes + 3) / 4;
+	int laneBits = (1 << lanes) - 1;
+
 	// Get inputs from Rack
-	float clockInput	= inputs[CLOCK_INPUT].getVoltage();
 	float clockActive	= inputs[CLOCK_INPUT].isConnected();
-	float randomInput	= inputs[RANDOM_INPUT].getVoltage();
-
-	// Read param section	
-	if (inputs[PATT_INPUT].isConnected()) {
-		inputPat = clamp(static_cast<unsigned int>(inputs[PATT_INPUT].getVoltage()), 0, 5);
-	} else {
-		inputPat = params[PATT_PARAM].getValue();
-	}	
-
-	if (inputs[LENGTH_INPUT].isConnected()) {
-		inputLen = clamp(static_cast<unsigned int>(inputs[LENGTH_INPUT].getVoltage()), 1, 16);
-	} else {
-		inputLen = params[LENGTH_PARAM].getValue();
-	}	
-
-	if (inputs[SIZE_INPUT].isConnected()) {
-		inputSize = clamp(static_cast<int>(inputs[SIZE_INPUT].getVoltage()), -24, 24);
-	} else {
-		inputSize = params[SIZE_PARAM].getValue();
-	}	
-
-	inputScale = static_cast<int>(params[SCALE_PARAM].getValue());
-	offset = static_cast<unsigned int>(params[OFFSET_PARAM].getValue());
-	int hold = digital::sgn(inputs[HOLD_INPUT].getVoltage(), 0.001);
-
-	// Process inputs
-	bool clockStatus = clockTrigger.process(clockInput);
-	bool randomStatus = randomTrigger.process(randomInput);
-
-	// Need to understand why this happens
-	if (inputLen == 0) {
-		if (debugEnabled(5000)) { std::cout << stepX << " " << id  << " InputLen == 0, aborting" << std::endl; }
-		return; // No inputs, no music
-	}
 
-	// If there is no clock input, then force that we are not running
-	if (!clockActive) {
-		isRunning = false;
+	unsigned int inputScale = static_cast<int>(params[SCALE_PARAM].getValue());
+	int offset = static_cast<unsigned int>(params[OFFSET_PARAM].getValue());
+
+	// Process inputs, all lanes together
+	int clockStatus = 0;
+	int randomStatus = 0;
+	for (int g = 0; g < nGroups; g++) {
+		simd::float_4 clockInput = inputs[CLOCK_INPUT].getPolyVoltageSimd<simd::float_4>(g * 4);
+		simd::float_4 randomInput = inputs[RANDOM_INPUT].getPolyVoltageSimd<simd::float_4>(g * 4);
+		clockStatus |= simd::movemask(clockTrigger[g].process(clockInput)) << (g * 4);
+		randomStatus |= simd::movemask(randomTrigger[g].process(randomInput)) << (g * 4);
 	}
+	clockStatus &= laneBits;
+	randomStatus &= laneBits;
 
-	bool restart = false;
+	int gates = 0;
+	int eocs = 0;
 
-	// Have we been clocked?
-	if (clockStatus) {
+	for (int l = 0; l < lanes; l++) {
 
-		// EOC was fired at last sequence step
-		if (eoc) {
-			eocPulse.trigger(digital::TRIGGER);
-			eoc = false;
+		// Read param section	
+		unsigned int inputPat;
+		if (inputs[PATT_INPUT].isConnected()) {
+			inputPat = clamp(static_cast<unsigned int>(inputs[PATT_INPUT].getPolyVoltage(l)), 0, 5);
+		} else {
+			inputPat = params[PATT_PARAM].getValue();
 		}	
-		
-		// If we are already running, process cycle
-		if (isRunning) {
 
-			if (debugEnabled()) { std::cout << stepX << " " << id  << " Advance Cycle: " << currPatt->getOffset() << std::endl; }
+		unsigned int inputLen;
+		if (inputs[LENGTH_INPUT].isConnected()) {
+			inputLen = clamp(static_cast<unsigned int>(inputs[LENGTH_INPUT].getPolyVoltage(l)), 1, 16);
+		} else {
+			inputLen = params[LENGTH_PARAM].getValue();
+		}	
 
-			// Reached the end of the pattern?
-			if (currPatt->isPatternFinished()) {
+		int inputSize;
+		if (inputs[SIZE_INPUT].isConnected()) {
+			inputSize = clamp(static_cast<int>(inputs[SIZE_INPUT].getPolyVoltage(l)), -24, 24);
+		} else {
+			inputSize = params[SIZE_PARAM].getValue();
+		}	
 
-				// Trigger EOC mechanism
-				eoc = true;
+		int hold = digital::sgn(inputs[HOLD_INPUT].getPolyVoltage(l), 0.001);
+
+		// The display follows lane 0
+		if (l == 0) {
+			DisplayState &state = displayState.write();
+			state.pattern = inputPat;
+			state.length = inputLen;
+			state.size = inputSize;
+			state.scale = inputScale;
+			state.offset = offset;
+			displayState.publish();
+		}
 
-				if (debugEnabled()) { std::cout << stepX << " " << id  << " Finished Cycle" << std::endl; }
-				restart = true;
+		// Need to understand why this happens
+		if (inputLen == 0) {
+			if (debugEnabled(5000)) { std::cout << stepX << " " << id  << " " << l << " InputLen == 0, aborting" << std::endl; }
+			continue; // No inputs, no music
+		}
 
-			} 
+		// If there is no clock input, then force that we are not running
+		if (!clockActive) {
+			isRunning[l] = false;
+		}
 
-			// Finally set the out voltage
-			outVolts = clamp(rootPitch + music::SEMITONE * (float)currPatt->getOffset(), -10.0f, 10.0f);
+		bool restart = false;
 
-			if (debugEnabled()) { std::cout << stepX << " " << id  << " Output V = " << outVolts << std::endl; }
+		// Have we been clocked?
+		if ((clockStatus >> l) & 1) {
 
-			// Pulse the output gate
-			gatePulse.trigger(digital::TRIGGER);
+			// EOC was fired at last sequence step
+			if (eoc[l]) {
+				eocs |= 1 << l;
+				eoc[l] = false;
+			}	
+			
+			// If we are already running, process cycle
+			if (isRunning[l]) {
 
-			// Completed 1 step
-			currPatt->advance();
+				arp::Sequence &patt = pattern[l];
 
-		} else {
+				if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Advance Cycle: " << patt.get() << std::endl; }
 
-			// Start a cycle
-			restart = true;
+				// Reached the end of the pattern?
+				if (patt.isLast()) {
 
-		}
+					// Trigger EOC mechanism
+					eoc[l] = true;
 
-	}
+					if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Finished Cycle" << std::endl; }
+					restart = true;
 
-	// Randomise if triggered
-	if (randomStatus && isRunning && hold != -1) {
-		currPatt->randomize();
-	}
+				} 
 
-	// If we have been triggered, start a new sequence
-	if (restart) {
+				// Finally set the out voltage
+				outVolts[l] = clamp(rootPitch[l] + music::SEMITONE * (float)patt.get(), -10.0f, 10.0f);
 
-		if (!hold) {
+				if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Output V = " << outVolts[l] << std::endl; }
+
+				// Pulse the output gate
+				gates |= 1 << l;
+
+				// Completed 1 step
+				patt.advance();
 
-			// Read input pitch
-			float inputPitch;
-			if (inputs[PITCH_INPUT].isConnected()) {
-				inputPitch = inputs[PITCH_INPUT].getVoltage();
 			} else {
-				inputPitch = 0.0;
+
+				// Start a cycle
+				restart = true;
+
 			}
 
-			// At the first step of the cycle
-			// So this is where we tweak the cycle parameters
-			pattern = inputPat;
-			length = inputLen;
-			size = inputSize;
-			scale = inputScale;
+		}
 
-			currPatt = patterns[pattern];
+		// Randomise if triggered
+		if (((randomStatus >> l) & 1) && isRunning[l] && hold != -1) {
+			pattern[l].randomize(rng);
+		}
 
-			// Save pitch
-			rootPitch = inputPitch;
+		// If we have been triggered, start a new sequence
+		if (restart) {
 
-			if (debugEnabled()) { std::cout << stepX << " " << id  << 
-				" Initiatise new Cycle: Pattern: " << currPatt->getName() << 
-				" Length: " << inputLen << std::endl; 
-			}
+			if (!hold) {
 
-			currPatt->initialise(length, scale, size, offset, repeatEnd);
+				// Read input pitch, and save it
+				if (inputs[PITCH_INPUT].isConnected()) {
+					rootPitch[l] = inputs[PITCH_INPUT].getPolyVoltage(l);
+				} else {
+					rootPitch[l] = 0.0;
+				}
 
-		} else {
+				// At the first step of the cycle
+				// So this is where we tweak the cycle parameters
+				patternId[l] = inputPat;
+
+				if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l <<
+					" Initiatise new Cycle: Pattern: " << PATTERNS[inputPat].name << 
+					" Length: " << inputLen << std::endl; 
+				}
+
+				pattern[l].initialise(PATTERNS[inputPat], inputLen, inputScale, inputSize, repeatEnd, offset);
+
+			} else {
+
+				if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l <<
+					" Hold new Cycle: Pattern: " << PATTERNS[patternId[l]].name << 
+					" Length: " << inputLen << std::endl; 
+				}
+
+				pattern[l].reset();
 
-			if (debugEnabled()) { std::cout << stepX << " " << id  << 
-				" Hold new Cycle: Pattern: " << currPatt->getName() << 
-				" Length: " << inputLen << std::endl; 
 			}
 
-			currPatt->reset();
+			// Start
+			isRunning[l] = true;
 
-		}
+		} 
 
-		// Start
-		isRunning = true;
+	}
 
-	} 
+	for (int g = 0; g < nGroups; g++) {
 
-	nextPattern = patterns[inputPat]->getName();
+		int runningBits = 0;
+		for (int j = 0; j < 4 && g * 4 + j < lanes; j++) {
+			runningBits |= isRunning[g * 4 + j] << j;
+		}
+
+		gatePulse[g].trigger(digital::laneMask(gates >> (g * 4)), digital::TRIGGER);
+		eocPulse[g].trigger(digital::laneMask(eocs >> (g * 4)), digital::TRIGGER);
 
-	// Set the value
-	outputs[OUT_OUTPUT].setVoltage(outVolts);
+		simd::float_4 gPulse = gatePulse[g].process(args.sampleTime);
+		simd::float_4 cPulse = eocPulse[g].process(args.sampleTime);
 
-	bool gPulse = gatePulse.process(args.sampleTime);
-	bool cPulse = eocPulse.process(args.sampleTime);
+		simd::float_4 gatesOn = digital::laneMask(runningBits);
+		if (gateMode == TRIGGER) {
+			gatesOn = gatesOn & gPulse;
+		} else if (gateMode == RETRIGGER) {
+			gatesOn = gatesOn & ~gPulse;
+		}
+
+		// Set the value
+		outputs[OUT_OUTPUT].setVoltageSimd(simd::float_4::load(outVolts + g * 4), g * 4);
+		outputs[GATE_OUTPUT].setVoltageSimd(simd::ifelse(gatesOn, 10.0f, 0.0f), g * 4);
+		outputs[EOC_OUTPUT].setVoltageSimd(simd::ifelse(cPulse, 10.0f, 0.0f), g * 4);
 
-	bool gatesOn = isRunning;
-	if (gateMode == TRIGGER) {
-		gatesOn = gatesOn && gPulse;
-	} else if (gateMode == RETRIGGER) {
-		gatesOn = gatesOn && !gPulse;
 	}
 
-	outputs[GATE_OUTPUT].setVoltage(gatesOn ? 10.0 : 0.0);
-	outputs[EOC_OUTPUT].setVoltage(cPulse ? 10.0 : 0.0);
+	outputs[OUT_OUTPUT].setChannels(lanes);
+	outputs[GATE_OUTPUT].setChannels(lanes);
+	outputs[EOC_OUTPUT].setChannels(lanes);
 
 }
 
@@ -703,31 +406,22 @@ struct Arp32Display : TransparentWidget {
 
 			nvgFillColor(ctx.vg, nvgRGBA(0x00, 0xFF, 0xFF, 0xFF));
 		
+			const Arp32::DisplayState &state = module->displayState.read();
+			const char *name = PATTERNS[state.pattern].name;
+
 			char text[128];
-			if (module->inputLen == 0) {
+			if (state.length == 0) {
 				snprintf(text, sizeof(text), "Error: inputLen == 0");
 			} else {
-				switch(module->inputScale) {
+				switch(state.scale) {
 					case 0: 
-						snprintf(text, sizeof(text), "%s (%d, %dst, %d)", 
-							module->nextPattern.c_str(),
-							module->inputLen,
-							module->inputSize,
-							module->offset);
+						snprintf(text, sizeof(text), "%s (%d, %dst, %d)", name, state.length, state.size, state.offset);
 						break;
 					case 1: 
-						snprintf(text, sizeof(text), "%s (%d, %dM, %d)", 
-							module->nextPattern.c_str(),
-							module->inputLen,
-							module->inputSize,
-							module->offset);
+						snprintf(text, sizeof(text), "%s (%d, %dM, %d)", name, state.length, state.size, state.offset);
 						break;
 					case 2: 
-						snprintf(text, sizeof(text), "%s (%d, %dm, %d)", 
-							module->nextPattern.c_str(),
-							module->inputLen,
-							module->inputSize,
-							module->offset);
+						snprintf(text, sizeof(text), "%s (%d, %dm, %d)", name, state.length, state.size, state.offset);
 						break;
 					default: snprintf(text, sizeof(text), "Error..."); break;
 				}
@@ -742,6 +436,7 @@ struct Arp32Widget : ModuleWidget {
 
 	std::vector<MenuOption<Arp32::GateMode>> gateOptions;
 	std::vector<MenuOption<bool>> noteOptions;
+	std::vector<MenuOption<bool>> laneOptions;
 
 	Arp32Widget(Arp32 *module) {
 
@@ -780,6 +475,9 @@ struct Arp32Widget : ModuleWidget {
 		noteOptions.emplace_back(std::string("Omit last note"), false);
 		noteOptions.emplace_back(std::string("Play last note"), true);
 
+		laneOptions.emplace_back(std::string("Off"), false);
+		laneOptions.emplace_back(std::string("One pattern per clock or pitch channel"), true);
+
 	}
 
 	void appendContextMenu(Menu *menu) override {
@@ -832,6 +530,26 @@ struct Arp32Widget : ModuleWidget {
 			}
 		};
 
+		struct LaneModeItem : Arp32Menu {
+			bool multiLane;
+			void onAction(const rack::event::Action &e) override {
+				module->multiLane = multiLane;
+			}
+		};
+
+		struct LaneModeMenu : Arp32Menu {
+			Menu *createChildMenu() override {
+				Menu *menu = new Menu;
+				for (auto opt: parent->laneOptions) {
+					LaneModeItem *item = createMenuItem<LaneModeItem>(opt.name, CHECKMARK(module->multiLane == opt.value));
+					item->module = module;
+					item->multiLane = opt.value;
+					menu->addChild(item);
+				}
+				return menu;
+			}
+		};
+
 		menu->addChild(construct<MenuLabel>());
 
 		GateModeMenu *item = createMenuItem<GateModeMenu>("Gate Mode");
@@ -844,6 +562,13 @@ struct Arp32Widget : ModuleWidget {
 		ritem->parent = this;
 		menu->addChild(ritem);
 
+		LaneModeMenu *litem = createMenuItem<LaneModeMenu>("Multi-lane mode");
+		litem->module = arp;
+		litem->parent = this;
+		menu->addChild(litem);
+
+		menu->addChild(gui::createFixedSeedItem(arp));
+
 	}
 
 };
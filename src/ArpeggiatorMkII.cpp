@@ -1,416 +1,31 @@
 #include "AH.hpp"
 #include "AHCommon.hpp"
+#include "dsp/arpeggio.hpp"
 
 #include <iostream>
 
 using namespace ah;
 
-struct Pattern {
-
-	unsigned int length = 0;
-	int trans = 0;
-	unsigned int scale = 0;
-	unsigned int count = 0;
-
-	unsigned int MAJOR[7] = {0,2,4,5,7,9,11};
-	unsigned int MINOR[7] = {0,2,3,5,7,8,10};
-
-	virtual std::string getName() = 0;
-
-	virtual void initialise(unsigned int l, unsigned int sc, int tr, bool freeRun) {
-		length = l;
-		trans = tr;
-		scale = sc;
-		count = 0;
-	};
-
-	virtual void advance() {
-		count++;
-	};
-
-	virtual int getOffset() = 0;
-
-	virtual bool isPatternFinished() = 0;
-
-	int getMajor(int count) {
-		int i = abs(count);
-		int sign = (count < 0) ? -1 : (count > 0);
-		return sign * ((i / 7) * 12 + MAJOR[i % 7]);
-	}
-
-	int getMinor(int count) {
-		int i = abs(count);
-		int sign = (count < 0) ? -1 : (count > 0);
-		return sign * ((i / 7) * 12 + MINOR[i % 7]);
-	}
-
-};
-
-struct UpPattern : Pattern {
-
-	std::string getName() override {
-		return "Up";
-	};
-
-	void initialise(unsigned int l, unsigned int sc, int tr, bool fr) override {
-		Pattern::initialise(l,sc,tr,fr);
-	}
-
-	int getOffset() override {
-
-		switch(scale) {
-			case 0: return count * trans; break;
-			case 1: return getMajor(count * trans); break;
-			case 2: return getMinor(count * trans); break;
-			default:
-				return count * trans; break;
-		}
-
-	}
-
-	bool isPatternFinished() override {
-		return(count == length);
-	}
-
-};
-
-struct DownPattern : Pattern {
-
-	int currSt = 0;
-
-	std::string getName() override {
-		return "Down";
-	};
-
-	void initialise(unsigned int l, unsigned int sc, int tr, bool fr) override {
-		Pattern::initialise(l,sc,tr,fr);
-		currSt = length - 1;
-	}
-
-	void advance() override {
-		Pattern::advance();
-		currSt--;
-	}
-
-	int getOffset() override {
-		switch(scale) {
-			case 0: return currSt * trans; break;
-			case 1: return getMajor(currSt * trans); break;
-			case 2: return getMinor(currSt * trans); break;
-			default:
-				return currSt * trans; break;
-		}
-	}
-
-	bool isPatternFinished() override {
-		return (currSt < 0);
-	}
-
-};
-
-struct UpDownPattern : Pattern {
-
-	unsigned int mag = 0;
-	unsigned int end = 0;
-
-	std::string getName() override {
-		return "UpDown";
-	};	
-
-	void initialise(unsigned int l, unsigned int sc, int tr, bool fr) override {
-		Pattern::initialise(l,sc,tr,fr);
-		mag = l - 1;
-		if (fr) {
-			end = 2 * l - 2;
-		} else {
-			end = 2 * l - 1;
-		}
-		if (end < 1) {
-			end = 1;
-		}
-	}
-
-	int getOffset() override {
-		
-		int note = (mag - abs(static_cast<int>(mag - count)));
-		
-		switch(scale) {
-			case 0: return note * trans; break;
-			case 1: return getMajor(note * trans); break;
-			case 2: return getMinor(note * trans); break;
-			default:
-				return note * trans; break;
-		}
-
-	}
-
-	bool isPatternFinished() override {
-		return(count == end);
-	}
-
-};
-
-struct DownUpPattern : Pattern {
-
-	unsigned int mag = 0;
-	unsigned int end = 0;
-	
-	std::string getName() override {
-		return "DownUp";
-	};	
-
-	void initialise(unsigned int l, unsigned int sc, int tr, bool fr) override {
-		Pattern::initialise(l,sc,tr,fr);
-		mag = l - 1;
-		if (fr) {
-			end = 2 * l - 2;
-		} else {
-			end = 2 * l - 1;
-		}
-		if (end < 1) {
-			end = 1;
-		}
-	}
-
-	int getOffset() override {
-
-		int note = -(mag - abs(static_cast<int>(mag - count)));
-
-		switch(scale) {
-			case 0: return note * trans; break;
-			case 1: return getMajor(note * trans); break;
-			case 2: return getMinor(note * trans); break;
-			default:
-				return note * trans; break;
-		}
-
-	}
-
-	bool isPatternFinished() override {
-		return(count == end);
-	}
-
+// In PATT_PARAM order. Free-running sequences do not repeat their ends
+constexpr arp::Pattern PATTERNS[] = {
+	{"Up",			arp::RISE,			1},
+	{"Down",		arp::FALL,			1},
+	{"UpDown",		arp::RISE_FALL,		1},
+	{"DownUp",		arp::RISE_FALL,		-1},
+	{"Rez",			arp::REZ,			0},
+	{"On The Run",	arp::ON_THE_RUN,	0}
 };
 
-struct NotePattern : Pattern {
-
-	std::vector<int> notes;
-
-	void initialise(unsigned int l, unsigned int sc, int tr, bool fr) override {
-		Pattern::initialise(l,sc,tr,fr);
-	}
-
-	int getOffset() override {
-		return getNote(count);
-	}
-
-	bool isPatternFinished() override {
-		return (count == static_cast<unsigned int>(notes.size()));
-	}
-
-	int getNote(int i) {
-		return notes[i];
-	}
-
-};
-
-struct RezPattern : NotePattern {
-	
-	std::string getName() override {
-		return "Rez";
-	};	
-
-	RezPattern() {
-		notes.clear();
-		notes.push_back(0);
-		notes.push_back(12);
-		notes.push_back(0);
-		notes.push_back(0);
-		notes.push_back(8);
-		notes.push_back(0);
-		notes.push_back(0);
-		notes.push_back(3);
-		notes.push_back(0);
-		notes.push_back(0);
-		notes.push_back(3);
-		notes.push_back(0);
-		notes.push_back(3);
-		notes.push_back(0);
-		notes.push_back(8);
-		notes.push_back(0);
-	}
-
-};
-
-struct OnTheRunPattern : NotePattern {
-
-	std::string getName() override {
-		return "On The Run";
-	};	
-
-	OnTheRunPattern() {
-		notes.clear();
-		notes.push_back(0);
-		notes.push_back(4);
-		notes.push_back(6);
-		notes.push_back(4);
-		notes.push_back(9);
-		notes.push_back(11);
-		notes.push_back(13);
-		notes.push_back(11);
-	}
-
-};
-
-struct Arpeggio {
-
-	virtual std::string getName() = 0;
-
-	virtual void initialise(unsigned int nPitches, bool fr) = 0;
-
-	virtual void advance() = 0;
-
-	virtual unsigned int getPitch() = 0;
-
-	virtual bool isArpeggioFinished() = 0;
-
-};
-
-struct RightArp : Arpeggio {
-
-	unsigned int index = 0;
-	unsigned int nPitches = 0;
-
-	std::string getName() override {
-		return "Right";
-	};
-
-	void initialise(unsigned int np, bool fr) override {
-		index = 0;
-		nPitches = np;
-	}
-
-	void advance() override {
-		index++;
-	}
-
-	unsigned int getPitch() override {
-		return index;
-	}
-
-	bool isArpeggioFinished() override {
-		return (index == nPitches);
-	}
-
-};
-
-struct LeftArp : Arpeggio {
-
-	int index = 0;
-	unsigned int nPitches = 0;
-
-	std::string getName() override {
-		return "Left";
-	};
-
-	void initialise(unsigned int np, bool fr) override {
-		nPitches = np;
-		index = nPitches - 1;
-	}
-
-	void advance() override {
-		index--;
-	}
-
-	unsigned int getPitch() override {
-		return index;
-	}
-
-	bool isArpeggioFinished() override {
-		return (index < 0);
-	}
-
-};
-
-struct RightLeftArp : Arpeggio {
-
-	unsigned int currSt = 0;
-	unsigned int mag = 0;
-	unsigned int end = 0;
-
-	std::string getName() override {
-		return "RightLeft";
-	};	
-
-	void initialise(unsigned int l, bool fr) override {
-		mag = l - 1;
-		if (fr) {
-			end = 2 * l - 2;
-		} else {
-			end = 2 * l - 1;
-		}
-		if (end < 1) {
-			end = 1;
-		}
-		currSt = 0;
-	}
-
-	void advance() override {
-		currSt++;
-	}
-
-	unsigned int getPitch() override {
-		return mag - abs(static_cast<int>(mag - currSt));
-	}
-
-	bool isArpeggioFinished() override {
-		return(currSt == end);
-	}
-
-};
-
-struct LeftRightArp : Arpeggio {
-
-	unsigned int currSt = 0;
-	unsigned int mag = 0;
-	unsigned int end = 0;
-
-	std::string getName() override {
-		return "LeftRight";
-	};
-
-	void initialise(unsigned int l, bool fr) override {
-		mag = l - 1;
-		if (fr) {
-			end = 2 * l - 2;
-		} else {
-			end = 2 * l - 1;
-		}
-		if (end < 1) {
-			end = 1;
-		}
-		currSt = 0;
-	}
-
-	void advance() override {
-		currSt++;
-	}
-
-	unsigned int getPitch() override {
-		return abs(static_cast<int>(mag - currSt));
-	}
-
-	bool isArpeggioFinished() override {
-		return(currSt == end);
-	}
-
-};
+// In ARP_PARAM order
+constexpr arp::Shape ARPEGGIOS[] = {arp::RISE, arp::FALL, arp::RISE_FALL, arp::FALL_RISE};
+constexpr const char *ARPEGGIO_NAMES[] = {"Right", "Left", "RightLeft", "LeftRight"};
 
 struct Arpeggiator2 : core::AHModule {
 
 	const static unsigned int MAX_STEPS = 16;
 	const static unsigned int MAX_DIST = 12; //Octave
 	const static unsigned int NUM_PITCHES = 6;
+	const static int MAX_LANES = 16;
 
 	enum ParamIds {
 		LOCK_PARAM,
@@ -464,7 +79,7 @@ struct Arpeggiator2 : core::AHModule {
 		configParam(LENGTH_PARAM, 1.0, 16.0, 1.0); 
 
 		onReset();
-		id = rand();
+		id = rng.next();
 		debugFlag = false;
 
 	}
@@ -472,10 +87,12 @@ struct Arpeggiator2 : core::AHModule {
 	void process(const ProcessArgs &args) override;
 
 	void onReset() override {
-		newSequence = 0;
-		newCycle = 0;
-		isRunning = false;
-		freeRunning = false;
+		for (int l = 0; l < MAX_LANES; l++) {
+			newSequence[l] = 0;
+			newCycle[l] = 0;
+			isRunning[l] = false;
+			freeRunning[l] = false;
+		}
 	}
 
 	json_t *dataToJson() override {
@@ -485,6 +102,9 @@ struct Arpeggiator2 : core::AHModule {
 		json_t *gateModeJ = json_integer((int) gateMode);
 		json_object_set_new(rootJ, "gateMode", gateModeJ);
 
+		// multiLane
+		json_object_set_new(rootJ, "multiLane", json_boolean(multiLane));
+
 		return rootJ;
 	}
 
@@ -495,6 +115,22 @@ struct Arpeggiator2 : core::AHModule {
 		if (gateModeJ) {
 			gateMode = (GateMode)json_integer_value(gateModeJ);
 		}
+
+		// multiLane
+		json_t *multiLaneJ = json_object_get(rootJ, "multiLane");
+		if (multiLaneJ) multiLane = json_boolean_value(multiLaneJ);
+	}
+
+	// In multi-lane mode each channel of CLOCK, TRIG or the PITCH inputs runs its own arpeggio
+	int getLanes() {
+		if (!multiLane) {
+			return 1;
+		}
+		int lanes = std::max(inputs[CLOCK_INPUT].getChannels(), inputs[TRIG_INPUT].getChannels());
+		for (unsigned int p = 0; p < NUM_PITCHES; p++) {
+			lanes = std::max(lanes, inputs[PITCH_INPUT + p].getChannels());
+		}
+		return clamp(lanes, 1, MAX_LANES);
 	}
 
 	enum GateMode {
@@ -504,74 +140,60 @@ struct Arpeggiator2 : core::AHModule {
 	};
 	GateMode gateMode = TRIGGER;
 	
-	rack::dsp::SchmittTrigger clockTrigger; // for clock
-	rack::dsp::SchmittTrigger trigTrigger;  // for step trigger
 	rack::dsp::SchmittTrigger lockTrigger;
 	rack::dsp::SchmittTrigger buttonTrigger;
 
-	rack::dsp::PulseGenerator triggerPulse;
-	rack::dsp::PulseGenerator gatePulse;
-	rack::dsp::PulseGenerator eosPulse;
-	rack::dsp::PulseGenerator eocPulse;
+	// Triggers and pulses for four lanes at a time
+	rack::dsp::TSchmittTrigger<simd::float_4> clockTrigger[MAX_LANES / 4]; // for clock
+	rack::dsp::TSchmittTrigger<simd::float_4> trigTrigger[MAX_LANES / 4];  // for step trigger
+
+	digital::AHPulseGenerator4 triggerPulse[MAX_LANES / 4];
+	digital::AHPulseGenerator4 gatePulse[MAX_LANES / 4];
+	digital::AHPulseGenerator4 eosPulse[MAX_LANES / 4];
+	digital::AHPulseGenerator4 eocPulse[MAX_LANES / 4];
 
 	bool locked = false;
+	bool multiLane = false;
 
-	float outVolts = 0;
-	bool isRunning = false;
-	bool freeRunning = false;
 	int error = 0;
 
-	int newSequence = 0;
-	int newCycle = 0;
 	const static int LAUNCH = 1;
 	const static int COUNTDOWN = 3;
 
-	unsigned int inputPat = 0;
-	unsigned int inputArp = 0;
-	unsigned int inputLen = 0;
-	int inputTrans = 0;
-	unsigned int inputScale = 0;
-
 	int poll = 5000;
 
-	unsigned int pattern = 0;
-	unsigned int arp = 0;
-	unsigned int length = 0;
-	float trans = 0;
-	unsigned int scale = 0;
-
-	UpPattern		patt_up; 
-	DownPattern		patt_down; 
-	UpDownPattern	patt_updown;
-	DownUpPattern	patt_downup;
-	RezPattern		patt_rez;
-	OnTheRunPattern	patt_ontherun;
-
-	UpPattern		ui_patt_up; 
-	DownPattern		ui_patt_down; 
-	UpDownPattern	ui_patt_updown;
-	DownUpPattern	ui_patt_downup;
-	RezPattern		ui_patt_rez;
-	OnTheRunPattern	ui_patt_ontherun;
-
-	RightArp		arp_right;
-	LeftArp			arp_left;
-	RightLeftArp	arp_rightleft;
-	LeftRightArp	arp_leftright;
-
-	RightArp		ui_arp_right;
-	LeftArp			ui_arp_left;
-	RightLeftArp	ui_arp_rightleft;
-	LeftRightArp	ui_arp_leftright;
-
-	Pattern *currPatt = &patt_up;
-	Arpeggio *currArp = &arp_right;
-
-	Pattern *uiPatt = &ui_patt_up;
-	Arpeggio *uiArp = &arp_right;
-
-	float pitches[6];
-	unsigned int nPitches = 0;
+	// Lane state
+	float outVolts[MAX_LANES] = {};
+	bool isRunning[MAX_LANES] = {};
+	bool freeRunning[MAX_LANES] = {};
+
+	int newSequence[MAX_LANES] = {};
+	int newCycle[MAX_LANES] = {};
+
+	// Sequence parameters, held while locked
+	unsigned int length[MAX_LANES] = {};
+	int trans[MAX_LANES] = {};
+	unsigned int scale[MAX_LANES] = {};
+
+	float pitches[MAX_LANES][NUM_PITCHES];
+	unsigned int nPitches[MAX_LANES] = {};
+
+	arp::Sequence pattern[MAX_LANES];
+	arp::Sequence arpeggio[MAX_LANES];
+	unsigned int patternId[MAX_LANES] = {};
+	unsigned int arpeggioId[MAX_LANES] = {};
+
+	// Selected pattern and arpeggio
+	struct DisplayState {
+		unsigned int pattern;
+		unsigned int arp;
+		unsigned int length;
+		int trans;
+		unsigned int scale;
+	};
+
+	core::SnapshotBuffer<DisplayState> displayState;
+
 	int id = 0;
 
 };
@@ -585,96 +207,45 @@ void Arpeggiator2::process(const ProcessArgs &args) {
 		return;
 	}
 	
+	int lanes = getLanes();
+	int nGroups = (lanes + 3) / 4;
+	int laneBits = (1 << lanes) - 1;
+
 	// Get inputs from Rack
-	float clockInput	= inputs[CLOCK_INPUT].getVoltage();
 	bool  clockActive	= inputs[CLOCK_INPUT].isConnected();
-	float trigInput		= inputs[TRIG_INPUT].getVoltage();
 	bool  trigActive	= inputs[TRIG_INPUT].isConnected();
 	float lockInput		= params[LOCK_PARAM].getValue();
 	float buttonInput	= params[TRIGGER_PARAM].getValue();
 	
-	// Read param section	
-	if (inputs[PATT_INPUT].isConnected()) {
-		inputPat = clamp(static_cast<unsigned int>(inputs[PATT_INPUT].getVoltage()), 0, 5);
-	} else {
-		inputPat = params[PATT_PARAM].getValue();
-	}
-
-	if (inputs[ARP_INPUT].isConnected()) {
-		inputArp = clamp(static_cast<unsigned int>(inputs[ARP_INPUT].getVoltage()), 0, 3);
-	} else {
-		inputArp = params[ARP_PARAM].getValue();
-	}	
-
-	if (inputs[LENGTH_INPUT].isConnected()) {
-		inputLen = clamp(static_cast<unsigned int>(inputs[LENGTH_INPUT].getVoltage()), 1, 16);
-	} else {
-		inputLen = params[LENGTH_PARAM].getValue();
-	}	
-
-	if (inputs[TRANS_INPUT].isConnected()) {
-		inputTrans = clamp(static_cast<int>(inputs[TRANS_INPUT].getVoltage()), -24, 24);
-	} else {
-		inputTrans = params[TRANS_PARAM].getValue();
-	}
-
-	inputScale = params[SCALE_PARAM].getValue();
+	unsigned int inputScale = params[SCALE_PARAM].getValue();
 
 	// Process inputs
-	bool clockStatus	= clockTrigger.process(clockInput);
-	bool triggerStatus	= trigTrigger.process(trigInput);
 	bool lockStatus		= lockTrigger.process(lockInput);
 	bool buttonStatus	= buttonTrigger.process(buttonInput);
 
-	// Read input pitches and assign to pitch array
-	unsigned int nValidPitches = 0;
-	float inputPitches[NUM_PITCHES];
-	for (unsigned int p = 0; p < NUM_PITCHES; p++) {
-		unsigned int index = PITCH_INPUT + p;
-		if (inputs[index].isConnected()) {
-			inputPitches[nValidPitches] = inputs[index].getVoltage();
-			nValidPitches++;
-		} else {
-			inputPitches[nValidPitches] = 0.0;
-		}
-	}
-
-	// if (debugEnabled()) {
-	// 	for (int p = 0; p < nValidPitches; p++) {
-	// 		std::cout << inputPitches[p] << std::endl;
-	// 	}
-	// }
-
-	// Always play something
-	if (nValidPitches == 0) {
-		if (debugEnabled()) { std::cout << stepX << " " << id  << " No inputs, assume single 0V pitch" << std::endl; }
-		nValidPitches = 1;
-	}
-
-	// Need to understand why this happens
-	if (inputLen == 0) {
-		if (debugEnabled()) { std::cout << stepX << " " << id  << " InputLen == 0, aborting" << std::endl; }
-		return; // No inputs, no music
-	}
+	// Clock and trigger for all lanes together. The trigger pulse holds off the clock just after a trigger
+	int clockStatus = 0;
+	int triggerStatus = 0;
+	int triggerHigh = 0;
+	for (int g = 0; g < nGroups; g++) {
+		simd::float_4 clockInput = inputs[CLOCK_INPUT].getPolyVoltageSimd<simd::float_4>(g * 4);
+		simd::float_4 trigInput = inputs[TRIG_INPUT].getPolyVoltageSimd<simd::float_4>(g * 4);
+		simd::float_4 clocked = clockTrigger[g].process(clockInput);
+		simd::float_4 triggered = trigTrigger[g].process(trigInput);
 
-	// If there is no clock input, then force that we are not running
-	if (!clockActive) {
-		isRunning = false;
-	}
+		// Has the trigger input been fired
+		triggerPulse[g].trigger(triggered, 5e-5);
 
-	// Has the trigger input been fired
-	if (triggerStatus) {
-		triggerPulse.trigger(5e-5);
-		if (debugEnabled()) { std::cout << stepX << " " << id  << " Triggered" << std::endl; }
-	}
+		// Update the trigger pulse and determine if it is still high
+		simd::float_4 high = triggerPulse[g].process(args.sampleTime);
 
-	// Update the trigger pulse and determine if it is still high
-	bool triggerHigh = triggerPulse.process(args.sampleTime);
-	if (debugEnabled()) {
-		if (triggerHigh) {
-			std::cout << stepX << " " << id  << " Trigger is high" << std::endl;
-		}
+		clockStatus |= simd::movemask(clocked) << (g * 4);
+		triggerStatus |= simd::movemask(triggered) << (g * 4);
+		triggerHigh |= simd::movemask(high) << (g * 4);
 	}
+	clockStatus &= laneBits;
+	triggerStatus &= laneBits;
+	triggerHigh &= laneBits;
 
 	// Update lock
 	if (lockStatus) {
@@ -682,220 +253,279 @@ void Arpeggiator2::process(const ProcessArgs &args) {
 		locked = !locked;
 	}
 
-	if (newSequence) {
-		newSequence--;
-		if (debugEnabled()) { std::cout << stepX << " " << id  << " Countdown newSequence: " << newSequence << std::endl; }
-	}
-
-	if (newCycle) {
-		newCycle--;
-		if (debugEnabled()) { std::cout << stepX << " " << id  << " Countdown newCycle: " << newCycle << std::endl; }
-	}
+	int gates = 0;
+	int eocs = 0;
+	int eoss = 0;
 
-	// OK so the problem here might be that the clock gate is still high right after the trigger gate fired on the previous step
-	// So we need to wait a while for the clock gate to go low
-	// Has the clock input been fired
-	bool isClocked = false;
-	if (clockStatus && !triggerHigh) {
-		if (debugEnabled()) { std::cout << stepX << " " << id  << " Clocked" << std::endl; }
-		isClocked = true;
-	}
+	for (int l = 0; l < lanes; l++) {
 
-	// Has the trigger input been fired, either on the input or button
-	if (triggerStatus || buttonStatus) {
-		if (debugEnabled()) { std::cout << stepX << " " << id  << " Start countdown " << clockActive <<std::endl; }
-		if (clockActive) {
-			newSequence = COUNTDOWN;
-			newCycle = COUNTDOWN;
+		// Read param section	
+		unsigned int inputPat;
+		if (inputs[PATT_INPUT].isConnected()) {
+			inputPat = clamp(static_cast<unsigned int>(inputs[PATT_INPUT].getPolyVoltage(l)), 0, 5);
+		} else {
+			inputPat = params[PATT_PARAM].getValue();
 		}
-	}
 
-	// Received trigger before EOS, fire EOS gate anyway
-	if (triggerStatus && isRunning && !currPatt->isPatternFinished()) {
-			// Pulse the EOS gate
-		eosPulse.trigger(digital::TRIGGER);
-		if (debugEnabled()) { std::cout << stepX << " " << id  << " Short sequence" << std::endl; }
-	}
+		unsigned int inputArp;
+		if (inputs[ARP_INPUT].isConnected()) {
+			inputArp = clamp(static_cast<unsigned int>(inputs[ARP_INPUT].getPolyVoltage(l)), 0, 3);
+		} else {
+			inputArp = params[ARP_PARAM].getValue();
+		}	
+
+		unsigned int inputLen;
+		if (inputs[LENGTH_INPUT].isConnected()) {
+			inputLen = clamp(static_cast<unsigned int>(inputs[LENGTH_INPUT].getPolyVoltage(l)), 1, 16);
+		} else {
+			inputLen = params[LENGTH_PARAM].getValue();
+		}	
 
-	// So this is where the free-running could be triggered
-	if (isClocked && !isRunning) { // Must have a clock and not be already running
-		if (!trigActive) { // If nothing plugged into the TRIG input
-			if (debugEnabled()) { std::cout << stepX << " " << id  << " Free running sequence; starting" << std::endl; }
-			freeRunning = true; // We're free-running
-			newSequence = COUNTDOWN;
-			newCycle = LAUNCH;
+		int inputTrans;
+		if (inputs[TRANS_INPUT].isConnected()) {
+			inputTrans = clamp(static_cast<int>(inputs[TRANS_INPUT].getPolyVoltage(l)), -24, 24);
 		} else {
-			if (debugEnabled()) { std::cout << stepX << " " << id  << " Triggered sequence; wait for trigger" << std::endl; }
-			freeRunning = false;
+			inputTrans = params[TRANS_PARAM].getValue();
 		}
-	}
 
-	// Detect cable being plugged in when free-running, stop free-running
-	if (freeRunning && trigActive && isRunning) {
-		if (debugEnabled()) { std::cout << stepX << " " << id  << " TRIG input re-connected" << std::endl; }
-		freeRunning = false;
-	}	
+		// Update UI, which follows lane 0
+		if (l == 0) {
+			DisplayState &state = displayState.write();
+			state.pattern = inputPat;
+			state.arp = inputArp;
+			state.length = inputLen;
+			state.trans = inputTrans;
+			state.scale = inputScale;
+			displayState.publish();
+		}
 
-	// Reached the end of the cycle
-	if (isRunning && isClocked && currArp->isArpeggioFinished()) {
+		// Read input pitches and assign to pitch array
+		unsigned int nValidPitches = 0;
+		float inputPitches[NUM_PITCHES];
+		for (unsigned int p = 0; p < NUM_PITCHES; p++) {
+			unsigned int index = PITCH_INPUT + p;
+			if (inputs[index].isConnected()) {
+				inputPitches[nValidPitches] = inputs[index].getPolyVoltage(l);
+				nValidPitches++;
+			} else {
+				inputPitches[nValidPitches] = 0.0;
+			}
+		}
 
-		// Completed 1 step
-		currPatt->advance();
+		// Always play something
+		if (nValidPitches == 0) {
+			if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " No inputs, assume single 0V pitch" << std::endl; }
+			nValidPitches = 1;
+		}
 
-		// Pulse the EOC gate
-		eocPulse.trigger(digital::TRIGGER);
-		if (debugEnabled()) { std::cout << stepX << " " << id  << " Finished Cycle" << std::endl; }
+		// Need to understand why this happens
+		if (inputLen == 0) {
+			if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " InputLen == 0, aborting" << std::endl; }
+			continue; // No inputs, no music
+		}
+
+		// If there is no clock input, then force that we are not running
+		if (!clockActive) {
+			isRunning[l] = false;
+		}
 
-		// Reached the end of the sequence
-		if (isRunning && currPatt->isPatternFinished()) {
+		bool laneTriggered = (triggerStatus >> l) & 1;
+		if (laneTriggered) {
+			if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Triggered" << std::endl; }
+		}
 
-			// Free running, so start new seqeuence & cycle
-			if (freeRunning) {
-				newCycle = COUNTDOWN;
-				newSequence = COUNTDOWN;
+		if (newSequence[l]) {
+			newSequence[l]--;
+			if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Countdown newSequence: " << newSequence[l] << std::endl; }
+		}
+
+		if (newCycle[l]) {
+			newCycle[l]--;
+			if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Countdown newCycle: " << newCycle[l] << std::endl; }
+		}
+
+		// OK so the problem here might be that the clock gate is still high right after the trigger gate fired on the previous step
+		// So we need to wait a while for the clock gate to go low
+		// Has the clock input been fired
+		bool isClocked = false;
+		if (((clockStatus >> l) & 1) && !((triggerHigh >> l) & 1)) {
+			if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Clocked" << std::endl; }
+			isClocked = true;
+		}
+
+		// Has the trigger input been fired, either on the input or button
+		if (laneTriggered || buttonStatus) {
+			if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Start countdown " << clockActive <<std::endl; }
+			if (clockActive) {
+				newSequence[l] = COUNTDOWN;
+				newCycle[l] = COUNTDOWN;
 			}
+		}
 
-			isRunning = false;
-	
+		// Received trigger before EOS, fire EOS gate anyway
+		if (laneTriggered && isRunning[l] && !pattern[l].isFinished()) {
 			// Pulse the EOS gate
-			eosPulse.trigger(digital::TRIGGER);
-			if (debugEnabled()) { std::cout << stepX << " " << id  << " Finished Sequence, flag: " << isRunning << std::endl; }
+			eoss |= 1 << l;
+			if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Short sequence" << std::endl; }
+		}
 
-		} else {
-			newCycle = LAUNCH;
-			if (debugEnabled()) { std::cout << stepX << " " << id  << " Flagging new cycle" << std::endl; }
+		// So this is where the free-running could be triggered
+		if (isClocked && !isRunning[l]) { // Must have a clock and not be already running
+			if (!trigActive) { // If nothing plugged into the TRIG input
+				if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Free running sequence; starting" << std::endl; }
+				freeRunning[l] = true; // We're free-running
+				newSequence[l] = COUNTDOWN;
+				newCycle[l] = LAUNCH;
+			} else {
+				if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Triggered sequence; wait for trigger" << std::endl; }
+				freeRunning[l] = false;
+			}
 		}
 
-	}
+		// Detect cable being plugged in when free-running, stop free-running
+		if (freeRunning[l] && trigActive && isRunning[l]) {
+			if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " TRIG input re-connected" << std::endl; }
+			freeRunning[l] = false;
+		}	
 
-	// If we have been triggered, start a new sequence
-	if (newSequence == LAUNCH) {
+		// Reached the end of the cycle
+		if (isRunning[l] && isClocked && arpeggio[l].isFinished()) {
 
-		// At the first step of the sequence
-		// So this is where we tweak the sequence parameters
+			// Completed 1 step
+			pattern[l].advance();
 
-		if (!locked) {
-			pattern = inputPat;
-			length = inputLen;
-			trans = inputTrans;
-			scale = inputScale;
+			// Pulse the EOC gate
+			eocs |= 1 << l;
+			if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Finished Cycle" << std::endl; }
 
-			switch(pattern) {
-				case 0:		currPatt = &patt_up; 		break;
-				case 1:		currPatt = &patt_down;		break;
-				case 2:		currPatt = &patt_updown;	break;
-				case 3:		currPatt = &patt_downup;	break;
-				case 4:		currPatt = &patt_rez;		break;
-				case 5:		currPatt = &patt_ontherun;	break;
-				default:	currPatt = &patt_up;		break;
-			};
+			// Reached the end of the sequence
+			if (isRunning[l] && pattern[l].isFinished()) {
 
-		}
+				// Free running, so start new seqeuence & cycle
+				if (freeRunning[l]) {
+					newCycle[l] = COUNTDOWN;
+					newSequence[l] = COUNTDOWN;
+				}
 
-		if (debugEnabled()) { std::cout << stepX << " " << id  << " Initiatise new Sequence: Pattern: " << currPatt->getName() << 
-			" Length: " << inputLen <<
-			" Locked: " << locked << std::endl; }
+				isRunning[l] = false;
+		
+				// Pulse the EOS gate
+				eoss |= 1 << l;
+				if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Finished Sequence, flag: " << isRunning[l] << std::endl; }
 
-		currPatt->initialise(length, scale, trans, freeRunning);
+			} else {
+				newCycle[l] = LAUNCH;
+				if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Flagging new cycle" << std::endl; }
+			}
 
-		// We're running now
-		isRunning = true;
+		}
 
-	}
+		// If we have been triggered, start a new sequence
+		if (newSequence[l] == LAUNCH) {
 
-	// Starting a new cycle
-	if (newCycle == LAUNCH) {
+			// At the first step of the sequence
+			// So this is where we tweak the sequence parameters
 
-		/// Reset the cycle counters
-		if (!locked) {
+			if (!locked) {
+				length[l] = inputLen;
+				trans[l] = inputTrans;
+				scale[l] = inputScale;
+				patternId[l] = inputPat;
+			}
 
-			arp = inputArp;
+			if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Initiatise new Sequence: Pattern: " << PATTERNS[patternId[l]].name << 
+				" Length: " << inputLen <<
+				" Locked: " << locked << std::endl; }
 
-			switch(arp) {
-				case 0: 	currArp = &arp_right;		break;
-				case 1: 	currArp = &arp_left;		break;
-				case 2: 	currArp = &arp_rightleft;	break;
-				case 3: 	currArp = &arp_leftright;	break;
-				default:	currArp = &arp_right;		break; 	
-			};
+			pattern[l].initialise(PATTERNS[patternId[l]], length[l], scale[l], trans[l], !freeRunning[l]);
 
-			// Copy pitches
-			for (unsigned int p = 0; p < nValidPitches; p++) {
-				pitches[p] = inputPitches[p];
-			}
-			nPitches = nValidPitches;
+			// We're running now
+			isRunning[l] = true;
 
 		}
 
-		if (debugEnabled()) { std::cout << stepX << " " << id  << " Initiatise new Cycle: " << nPitches << " " << currArp->getName() << std::endl; }
+		// Starting a new cycle
+		if (newCycle[l] == LAUNCH) {
 
-		currArp->initialise(nPitches, freeRunning);
+			/// Reset the cycle counters
+			if (!locked) {
 
-	}
+				arpeggioId[l] = inputArp;
+
+				// Copy pitches
+				for (unsigned int p = 0; p < nValidPitches; p++) {
+					pitches[l][p] = inputPitches[p];
+				}
+				nPitches[l] = nValidPitches;
 
-	// Advance the sequence
-	// Are we starting a sequence or are running and have been clocked; if so advance the sequence
-	// Only advance from the clock
-	if (isRunning && (isClocked || newCycle == LAUNCH)) {
+			}
 
-		if (debugEnabled()) { std::cout << stepX << " " << id  << " Advance Cycle: " << currArp->getPitch() << std::endl; }
+			if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Initiatise new Cycle: " << nPitches[l] << " " << ARPEGGIO_NAMES[arpeggioId[l]] << std::endl; }
 
-		if (debugEnabled()) { std::cout << stepX << " " << id  << " Advance Cycle: " << pitches[currArp->getPitch()] << " " << (float)currPatt->getOffset() << std::endl; }
+			arpeggio[l].initialise(ARPEGGIOS[arpeggioId[l]], nPitches[l], !freeRunning[l]);
 
-		// Finally set the out voltage
-		outVolts = clamp(pitches[currArp->getPitch()] + music::SEMITONE * (float)currPatt->getOffset(), -10.0f, 10.0f);
+		}
 
-		if (debugEnabled()) { std::cout << stepX << " " << id  << " Output V = " << outVolts << std::endl; }
+		// Advance the sequence
+		// Are we starting a sequence or are running and have been clocked; if so advance the sequence
+		// Only advance from the clock
+		if (isRunning[l] && (isClocked || newCycle[l] == LAUNCH)) {
 
-		// Update counters
-		currArp->advance();
+			if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Advance Cycle: " << arpeggio[l].get() << std::endl; }
 
-		// Pulse the output gate
-		gatePulse.trigger(digital::TRIGGER);
-		
-	}
+			if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Advance Cycle: " << pitches[l][arpeggio[l].get()] << " " << (float)pattern[l].get() << std::endl; }
 
-	// Update UI
-	switch(inputPat) {
-		case 0:		uiPatt = &ui_patt_up; 		break;
-		case 1:		uiPatt = &ui_patt_down;		break;
-		case 2:		uiPatt = &ui_patt_updown;	break;
-		case 3:		uiPatt = &ui_patt_downup;	break;
-		case 4:		uiPatt = &ui_patt_rez;		break;
-		case 5:		uiPatt = &ui_patt_ontherun;	break;
-		default:	uiPatt = &ui_patt_up;		break;
-	};
+			// Finally set the out voltage
+			outVolts[l] = clamp(pitches[l][arpeggio[l].get()] + music::SEMITONE * (float)pattern[l].get(), -10.0f, 10.0f);
 
-	uiPatt->initialise(inputLen, inputScale, inputTrans, freeRunning);
+			if (debugEnabled()) { std::cout << stepX << " " << id  << " " << l << " Output V = " << outVolts[l] << std::endl; }
 
-	switch(inputArp) {
-		case 0: 	uiArp = &ui_arp_right;		break;
-		case 1: 	uiArp = &ui_arp_left;		break;
-		case 2: 	uiArp = &ui_arp_rightleft;	break;
-		case 3: 	uiArp = &ui_arp_leftright;	break;
-		default:	uiArp = &ui_arp_right;		break; 	
-	};
+			// Update counters
+			arpeggio[l].advance();
+
+			// Pulse the output gate
+			gates |= 1 << l;
+			
+		}
 
-	uiArp->initialise(nPitches, freeRunning);
+	}
 
 	// Set the value
 	lights[LOCK_LIGHT].setBrightness(locked ? 1.0 : 0.0);
-	outputs[OUT_OUTPUT].setVoltage(outVolts);
 
-	bool gPulse = gatePulse.process(args.sampleTime);
-	bool sPulse = eosPulse.process(args.sampleTime);
-	bool cPulse = eocPulse.process(args.sampleTime);
+	for (int g = 0; g < nGroups; g++) {
+
+		int runningBits = 0;
+		for (int j = 0; j < 4 && g * 4 + j < lanes; j++) {
+			runningBits |= isRunning[g * 4 + j] << j;
+		}
+
+		gatePulse[g].trigger(digital::laneMask(gates >> (g * 4)), digital::TRIGGER);
+		eosPulse[g].trigger(digital::laneMask(eoss >> (g * 4)), digital::TRIGGER);
+		eocPulse[g].trigger(digital::laneMask(eocs >> (g * 4)), digital::TRIGGER);
+
+		simd::float_4 gPulse = gatePulse[g].process(args.sampleTime);
+		simd::float_4 sPulse = eosPulse[g].process(args.sampleTime);
+		simd::float_4 cPulse = eocPulse[g].process(args.sampleTime);
+
+		simd::float_4 gatesOn = digital::laneMask(runningBits);
+		if (gateMode == TRIGGER) {
+			gatesOn = gatesOn & gPulse;
+		} else if (gateMode == RETRIGGER) {
+			gatesOn = gatesOn & ~gPulse;
+		}
+
+		outputs[OUT_OUTPUT].setVoltageSimd(simd::float_4::load(outVolts + g * 4), g * 4);
+		outputs[GATE_OUTPUT].setVoltageSimd(simd::ifelse(gatesOn, 10.0f, 0.0f), g * 4);
+		outputs[EOS_OUTPUT].setVoltageSimd(simd::ifelse(sPulse, 10.0f, 0.0f), g * 4);
+		outputs[EOC_OUTPUT].setVoltageSimd(simd::ifelse(cPulse, 10.0f, 0.0f), g * 4);
 
-	bool gatesOn = isRunning;
-	if (gateMode == TRIGGER) {
-		gatesOn = gatesOn && gPulse;
-	} else if (gateMode == RETRIGGER) {
-		gatesOn = gatesOn && !gPulse;
 	}
 
-	outputs[GATE_OUTPUT].setVoltage(gatesOn ? 10.0 : 0.0);
-	outputs[EOS_OUTPUT].setVoltage(sPulse ? 10.0 : 0.0);
-	outputs[EOC_OUTPUT].setVoltage(cPulse ? 10.0 : 0.0);
+	outputs[OUT_OUTPUT].setChannels(lanes);
+	outputs[GATE_OUTPUT].setChannels(lanes);
+	outputs[EOS_OUTPUT].setChannels(lanes);
+	outputs[EOC_OUTPUT].setChannels(lanes);
 
 }
 
@@ -926,26 +556,28 @@ struct Arpeggiator2Display : TransparentWidget {
 			nvgTextLetterSpacing(ctx.vg, -1);
 			nvgFillColor(ctx.vg, nvgRGBA(0x00, 0xFF, 0xFF, 0xFF));
 
+			const Arpeggiator2::DisplayState &state = module->displayState.read();
+
 			char text[128];
-			if (module->inputLen == 0) {
+			if (state.length == 0) {
 				snprintf(text, sizeof(text), "Error: inputLen == 0");
 				nvgText(ctx.vg, pos.x + 10, pos.y + 5, text, NULL);			
 			} else {
-				snprintf(text, sizeof(text), "Pattern: %s", module->uiPatt->getName().c_str());
+				snprintf(text, sizeof(text), "Pattern: %s", PATTERNS[state.pattern].name);
 				nvgText(ctx.vg, pos.x + 10, pos.y + 5, text, NULL);
 
-				snprintf(text, sizeof(text), "Length: %d", module->uiPatt->length);
+				snprintf(text, sizeof(text), "Length: %d", state.length);
 				nvgText(ctx.vg, pos.x + 10, pos.y + 25, text, NULL);
 
-				switch(module->uiPatt->scale) {
-					case 0: snprintf(text, sizeof(text), "Transpose: %d s.t.", module->uiPatt->trans); break;
-					case 1: snprintf(text, sizeof(text), "Transpose: %d Maj. int.", module->uiPatt->trans); break;
-					case 2: snprintf(text, sizeof(text), "Transpose: %d Min. int.", module->uiPatt->trans); break;
+				switch(state.scale) {
+					case 0: snprintf(text, sizeof(text), "Transpose: %d s.t.", state.trans); break;
+					case 1: snprintf(text, sizeof(text), "Transpose: %d Maj. int.", state.trans); break;
+					case 2: snprintf(text, sizeof(text), "Transpose: %d Min. int.", state.trans); break;
 					default: snprintf(text, sizeof(text), "Error..."); break;
 				}
 				nvgText(ctx.vg, pos.x + 10, pos.y + 45, text, NULL);
 
-				snprintf(text, sizeof(text), "Arpeggio: %s", module->uiArp->getName().c_str());
+				snprintf(text, sizeof(text), "Arpeggio: %s", ARPEGGIO_NAMES[state.arp]);
 				nvgText(ctx.vg, pos.x + 10, pos.y + 65, text, NULL);
 			}
 		}
@@ -1027,11 +659,39 @@ struct Arpeggiator2Widget : ModuleWidget {
 			}
 		};
 
+		struct LaneModeItem : MenuItem {
+			Arpeggiator2 *module;
+			bool multiLane;
+			void onAction(const rack::event::Action &e) override {
+				module->multiLane = multiLane;
+			}
+		};
+
+		struct LaneModeMenu : MenuItem {
+			Arpeggiator2 *module;
+			Menu *createChildMenu() override {
+				Menu *menu = new Menu;
+				std::vector<bool> modes = {false, true};
+				std::vector<std::string> names = {"Off", "One arpeggio per clock, trigger or pitch channel"};
+				for (size_t i = 0; i < modes.size(); i++) {
+					LaneModeItem *item = createMenuItem<LaneModeItem>(names[i], CHECKMARK(module->multiLane == modes[i]));
+					item->module = module;
+					item->multiLane = modes[i];
+					menu->addChild(item);
+				}
+				return menu;
+			}
+		};
+
 		menu->addChild(construct<MenuLabel>());
 		GateModeMenu *item = createMenuItem<GateModeMenu>("Gate Mode");
 		item->module = arp;
 		menu->addChild(item);
 
+		LaneModeMenu *litem = createMenuItem<LaneModeMenu>("Multi-lane mode");
+		litem->module = arp;
+		menu->addChild(litem);
+
 	}
 
 };
@@ -1,6 +1,7 @@
 #include "AH.hpp"
 #include "AHCommon.hpp"
 
+#include <array>
 #include <iostream>
 
 using namespace ah;
@@ -60,7 +61,7 @@ struct Bombe : core::AHModule {
 		paramQuantities[Y_PARAM]->description = "The deviation of the next chord update from the mode rule";
 
 		for (auto b: buffer) {
-			b.setVoltages(music::defaultChord.formula, offset);
+			b.setVoltages(music::defaultChord.formula, offset, rng);
 		}
 
 	}
@@ -140,13 +141,8 @@ struct Bombe : core::AHModule {
 	int mode = 1; 				// 0 = random chord, 1 = chord in key, 2 = chord in mode
 	int allowedInversions = 0;	// 0 = root only, 1 = root + first, 2 = root, first, second
 
-	music::KnownChords knownChords;
-
-	std::string rootName;
-	std::string modeName;
-
 	BombeChord buffer[BUFFERSIZE];
-	BombeChord displayBuffer[BUFFERSIZE];
+	core::SnapshotBuffer<std::array<BombeChord, BUFFERSIZE>> displayBuffer;
 
 };
 
@@ -186,24 +182,6 @@ void Bombe::process(const ProcessArgs &args) {
 		locked = true;
 	}
 
-	switch(mode) {
-		case 0: // Random
-			rootName = "";
-			modeName = "";
-			break;
-		case 1: // Simple
-			rootName = music::NoteDegreeModeNames[currRoot][0][currMode];
-			modeName = music::modeNames[currMode];
-			break;
-		case 2: // Galaxy
-			rootName = music::NoteDegreeModeNames[currRoot][0][currMode];
-			modeName = music::modeNames[currMode];
-			break;
-		default:
-			rootName = "";
-			modeName = "";
-	}
-
 	if (clocked) {
 
 		// Grab value from last element of sub-array, which will be the new head value
@@ -220,7 +198,7 @@ void Bombe::process(const ProcessArgs &args) {
 			buffer[0] = lastValue;
 		} else {
 
-			if (random::uniform() < x) {
+			if (rng.uniform() < x) {
 				// Buffer update skipped
 				buffer[0] = lastValue;
 			} else {
@@ -235,26 +213,18 @@ void Bombe::process(const ProcessArgs &args) {
 					default: modeSimple(lastValue, y);
 				}
 
-				const music::InversionDefinition &invDef = knownChords.getChord(buffer[0]);
-				buffer[0].setVoltages(invDef.formula, offset);
+				const music::InversionDefinition &invDef = music::knownChords.getChord(buffer[0]);
+				buffer[0].setVoltages(invDef, offset, rng);
 
 			}
 		}
 
+		std::array<BombeChord, BUFFERSIZE> &history = displayBuffer.write();
 		for(int i = BUFFERSIZE - 1; i > 0; i--) {
-			displayBuffer[i] = displayBuffer[i-1];
+			history[i] = history[i-1];
 		}
-		displayBuffer[0] = buffer[0];
-
-		// for(int i = 0; i < BUFFERSIZE; i++) {
-		// 	std::cout << displayBuffer[i].chord << ",";
-		// }
-		// std::cout << std::endl;
-
-		// for(int i = 0; i < BUFFERSIZE; i++) {
-		// 	std::cout << displayBuffer[i].rootNote << ",";
-		// }
-		// std::cout << std::endl << std::endl;
+		history[0] = buffer[0];
+		displayBuffer.publishAndCopy();
 		
 	}
 
@@ -280,19 +250,19 @@ void Bombe::process(const ProcessArgs &args) {
 void Bombe::modeSimple(const BombeChord & lastValue, float y) {
 
 	// Recalculate new value of buffer[0].outVolts from lastValue
-	int shift = (rand() % (N_DEGREES - 1)) + 1; // 1 - 6 - always new chord
+	int shift = (rng.integer(N_DEGREES - 1)) + 1; // 1 - 6 - always new chord
 	buffer[0].modeDegree = (lastValue.modeDegree + shift) % N_DEGREES; // FIXME, come from mode2 modeDeg == -1!
 
 	// quality 0 = Maj, 1 = Min, 2 = Dim
 	music::getRootFromMode(currMode,currRoot,buffer[0].modeDegree,&(buffer[0].rootNote),&(buffer[0].quality));
 
-	if (random::uniform() < y) {
-		buffer[0].chord = QualityMap[buffer[0].quality][rand() % QMAP_SIZE]; // Get the index into the main chord table
+	if (rng.uniform() < y) {
+		buffer[0].chord = QualityMap[buffer[0].quality][rng.integer(QMAP_SIZE)]; // Get the index into the main chord table
 	} else {
 		buffer[0].chord = Quality2Chord[buffer[0].quality]; // Get the index into the main chord table
 	}
 
-	buffer[0].inversion = InversionMap[allowedInversions][rand() % QMAP_SIZE];
+	buffer[0].inversion = InversionMap[allowedInversions][rng.integer(QMAP_SIZE)];
 	buffer[0].key = currRoot;
 	buffer[0].mode = currMode;
 
@@ -301,11 +271,11 @@ void Bombe::modeSimple(const BombeChord & lastValue, float y) {
 void Bombe::modeRandom(const BombeChord & lastValue, float y) {
 
 	// Recalculate new value of buffer[0].outVolts from lastValue
-	float p = random::uniform();
+	float p = rng.uniform();
 	if (p < y) {
-		buffer[0].rootNote = rand() % 12; 
+		buffer[0].rootNote = rng.integer(12); 
 	} else {
-		buffer[0].rootNote = MajorScale[rand() % 7]; 
+		buffer[0].rootNote = MajorScale[rng.integer(7)]; 
 	}
 
 	buffer[0].modeDegree = -1; 
@@ -313,22 +283,22 @@ void Bombe::modeRandom(const BombeChord & lastValue, float y) {
 	buffer[0].key = -1; 
 	buffer[0].mode = -1; 
 
-	float index = (float)(knownChords.chords.size()) * y;
+	float index = (float)(music::knownChords.chords.size()) * y;
 
-	buffer[0].chord = rand() % std::max(2, (int)index); // Major and minor chords always allowed
-	buffer[0].inversion = InversionMap[allowedInversions][rand() % QMAP_SIZE];
+	buffer[0].chord = rng.integer(std::max(2, (int)index)); // Major and minor chords always allowed
+	buffer[0].inversion = InversionMap[allowedInversions][rng.integer(QMAP_SIZE)];
 
 }
 
 void Bombe::modeKey(const BombeChord & lastValue, float y) {
 
-	int shift = (rand() % (N_DEGREES - 1)) + 1; // 1 - 6 - always new chord
+	int shift = (rng.integer(N_DEGREES - 1)) + 1; // 1 - 6 - always new chord
 	buffer[0].modeDegree = (lastValue.modeDegree + shift) % N_DEGREES; // FIXME, come from mode2 modeDeg == -1!
 
 	music::getRootFromMode(currMode,currRoot,buffer[0].modeDegree,&(buffer[0].rootNote),&(buffer[0].quality));
 
-	buffer[0].chord = (rand() % (knownChords.chords.size() - 1)); // Get the index into the main chord table
-	buffer[0].inversion = InversionMap[allowedInversions][rand() % QMAP_SIZE];
+	buffer[0].chord = rng.integer(music::knownChords.chords.size() - 1); // Get the index into the main chord table
+	buffer[0].inversion = InversionMap[allowedInversions][rng.integer(QMAP_SIZE)];
 	buffer[0].key = currRoot;
 	buffer[0].mode = currMode;
 
@@ -336,7 +306,7 @@ void Bombe::modeKey(const BombeChord & lastValue, float y) {
 
 void Bombe::modeGalaxy(const BombeChord & lastValue, float y) {
 
-	float excess = y - random::uniform();
+	float excess = y - rng.uniform();
 
 	if (excess < 0.0) {
 		modeSimple(lastValue, y);
@@ -376,26 +346,28 @@ struct BombeDisplay : TransparentWidget {
 
 			char text[128];
 
+			const std::array<BombeChord, Bombe::BUFFERSIZE> &history = module->displayBuffer.read();
+
 			for (int i = 0; i < 7; i++)  {
 
-				std::string chordName = "";
-				std::string chordExtName = "";
+				char chordName[64];
+				const char *chordExtName = "";
 
-				BombeChord &bC = module->displayBuffer[i];
+				const BombeChord &bC = history[i];
 
-				music::InversionDefinition &invDef = module->knownChords.chords[bC.chord].inversions[bC.inversion];
+				const music::InversionDefinition &invDef = music::knownChords.getChord(bC);
 
 				if (bC.key != -1 && bC.mode != -1) {
-					chordName = invDef.getName(bC.mode, bC.key, bC.modeDegree, bC.rootNote);
+					invDef.formatName(chordName, sizeof(chordName), bC.mode, bC.key, bC.modeDegree, bC.rootNote);
 				} else {
-					chordName = invDef.getName(bC.rootNote);
+					invDef.formatName(chordName, sizeof(chordName), bC.rootNote);
 				}
 
 				if (bC.modeDegree != -1 && bC.mode != -1) { 
 					chordExtName = music::DegreeString[bC.mode][bC.modeDegree];
 				}
 
-				snprintf(text, sizeof(text), "%s %s", chordName.c_str(), chordExtName.c_str());
+				snprintf(text, sizeof(text), "%s %s", chordName, chordExtName);
 				nvgText(ctx.vg, box.pos.x + 5, box.pos.y + i * 14, text, NULL);
 				nvgFillColor(ctx.vg, nvgRGBA(0, 255, 255, 223 - i * 32));
 
@@ -404,11 +376,10 @@ struct BombeDisplay : TransparentWidget {
 			nvgFillColor(ctx.vg, nvgRGBA(0x00, 0xFF, 0xFF, 0xFF));
 
 			nvgTextAlign(ctx.vg, NVG_ALIGN_RIGHT);
-			snprintf(text, sizeof(text), "%s", module->rootName.c_str());
-			nvgText(ctx.vg, box.size.x - 5, box.pos.y, text, NULL);
-
-			snprintf(text, sizeof(text), "%s", module->modeName.c_str());
-			nvgText(ctx.vg, box.size.x - 5, box.pos.y + 11, text, NULL);
+			if (module->mode == 1 || module->mode == 2) { // Simple and Galaxy modes follow the key and mode
+				nvgText(ctx.vg, box.size.x - 5, box.pos.y, music::NoteDegreeModeNames[module->currRoot][0][module->currMode], NULL);
+				nvgText(ctx.vg, box.size.x - 5, box.pos.y + 11, music::modeNames[module->currMode], NULL);
+			}
 
 		}
 
@@ -585,6 +556,8 @@ struct BombeWidget : ModuleWidget {
 		scaleItem->parent = this;
 		menu->addChild(scaleItem);
 
+		menu->addChild(gui::createFixedSeedItem(bombe));
+
      }
 
 };
@@ -14,6 +14,19 @@ const float POSMAX = 90.0f * 0.5f * PI_180;
 const float ONE_POSMAX = 1.0f / POSMAX;
 const float SQRT2_2 = sqrt(2.0) / 2.0;
 const int 	NUM_PITCHES = 6;
+const int	MAX_UNISON = 8;
+const int	MAX_VOICES = NUM_PITCHES * MAX_UNISON;
+const int	MAX_GROUPS = MAX_VOICES / 4; // Voices run four to a simd::float_4
+const float	UNISON_WIDTH = 0.5f * POSMAX; // Pan offset of the outermost unison voices, before SPREAD_PARAM
+
+// Oscillator outputs needed by each WAVE_PARAM setting
+const int WAVE_OUTPUTS[5] = {
+	EvenVCO<simd::float_4>::SINE,
+	EvenVCO<simd::float_4>::SAW,
+	EvenVCO<simd::float_4>::DOUBLESAW,
+	EvenVCO<simd::float_4>::SQUARE,
+	EvenVCO<simd::float_4>::EVEN
+};
 
 struct Chord : core::AHModule {
 
@@ -89,6 +102,12 @@ struct Chord : core::AHModule {
 
 		float voicePosDeg[6] = {-90.0f, 90.0f, -54.0f, 54.0f, -18.0f, 18.0f};
 
+		for (int v = 0; v < MAX_VOICES; v++) {
+			angle[v] = 0.0f;
+			left[v]  = SQRT2_2;
+			right[v] = SQRT2_2;
+		}
+
 		for (int n = 0; n < NUM_PITCHES; n++) {
 			configParam(WAVE_PARAM + n, 0.0f, 4.0f, 0.0f, "Waveform");
 			configParam(OCTAVE_PARAM + n, -3.0f, 3.0f, 0.0f, "Octave");
@@ -102,21 +121,88 @@ struct Chord : core::AHModule {
 		configParam(SPREAD_PARAM, 0.0f, 1.0f, 1.0f, "Spread");
 		paramQuantities[SPREAD_PARAM]->description = "Spread of voices across stereo field";
 
+		reseed();
+
 	}
 
+	enum Engine {
+		ENGINE_MINBLEP,
+		ENGINE_TABLE_LINEAR,
+		ENGINE_TABLE_CUBIC
+	};
+
 	void process(const ProcessArgs &args) override;
 
+	json_t *dataToJson() override {
+		json_t *rootJ = json_object();
+
+		// engine
+		json_object_set_new(rootJ, "engine", json_integer(engine));
+
+		// unison
+		json_object_set_new(rootJ, "unison", json_integer(unison));
+
+		// unisonDetune
+		json_object_set_new(rootJ, "unisonDetune", json_real(unisonDetune));
+
+		return rootJ;
+	}
+
+	void dataFromJson(json_t *rootJ) override {
+		// engine
+		json_t *engineJ = json_object_get(rootJ, "engine");
+		if (engineJ) engine = clamp((int)json_integer_value(engineJ), 0, 2);
+
+		// unison
+		json_t *unisonJ = json_object_get(rootJ, "unison");
+		if (unisonJ) unison = clamp((int)json_integer_value(unisonJ), 1, MAX_UNISON);
+
+		// unisonDetune
+		json_t *unisonDetuneJ = json_object_get(rootJ, "unisonDetune");
+		if (unisonDetuneJ) unisonDetune = clamp((float)json_number_value(unisonDetuneJ), 0.0f, 100.0f);
+	}
+
 	rack::dsp::SchmittTrigger moveTrigger;
 	rack::dsp::PulseGenerator triggerPulse;
 
-	float angle = 0.0;
-	float left  = SQRT2_2 * (cos(0.0) - sin(0.0));
-	float right = SQRT2_2 * (cos(0.0) + sin(0.0));
+	// Pan law per voice, recalculated only when the angle moves
+	float angle[MAX_VOICES];
+	float left[MAX_VOICES];
+	float right[MAX_VOICES];
+
+	int engine = ENGINE_MINBLEP;
 
-	EvenVCO oscillator[NUM_PITCHES];
+	int unison = 1; // Voices per pitch
+	float unisonDetune = 10.0f; // Cents between the outermost unison voices and the pitch
+
+	// The voices of all the pitches are packed together, pitch i owning voices i * unison to (i + 1) * unison - 1
+	EvenVCO<simd::float_4> oscillator[MAX_GROUPS];
+	WavetableVCO<simd::float_4> tableOscillator[MAX_GROUPS];
+
+	// Unison voices start at random phases so they do not sum coherently
+	void onReseed() override {
+		for (int g = 0; g < MAX_GROUPS; g++) {
+			for (int j = 0; j < 4; j++) {
+				oscillator[g].phase[j] = rng.uniform();
+				tableOscillator[g].phase[j] = oscillator[g].phase[j];
+			}
+		}
+	}
 
 };
 
+// The output each voice's WAVE_PARAM selects, from either engine
+template <typename O>
+static float selectWave(const O &osc, int lane, int wave) {
+	switch(wave) {
+		case 1:		return osc.saw[lane];
+		case 2:		return osc.doubleSaw[lane];
+		case 3:		return osc.square[lane];
+		case 4:		return osc.even[lane];
+		default:	return osc.sine[lane];
+	}
+}
+
 void Chord::process(const ProcessArgs &args) {
 
 	AHModule::step();
@@ -126,6 +212,10 @@ void Chord::process(const ProcessArgs &args) {
 
 	float spread = params[SPREAD_PARAM].getValue();
 
+	int wave[NUM_PITCHES];
+	float pitch[NUM_PITCHES];
+	float pw[NUM_PITCHES];
+
 	for (int i = 0; i < NUM_PITCHES; i++) {
 
 		float inputPitchCV = 0.0f;
@@ -140,37 +230,80 @@ void Chord::process(const ProcessArgs &args) {
 			}
 		}
 
-		int side = i % 2;
-
 		float pitchCv = inputPitchCV + params[OCTAVE_PARAM + i].getValue();
 		float pitchFine = params[DETUNE_PARAM + i].getValue() / 12.0; // +- 1V
-		float attn = params[ATTN_PARAM + i].getValue();
-		oscillator[i].pw = params[PW_PARAM + i].getValue() + params[PWM_PARAM + i].getValue() * inputs[PW_INPUT + i].getVoltage() / 10.0f;
-		oscillator[i].step(args.sampleTime, pitchFine + pitchCv); // 1V/OCT
-
-		float amp = 0.0f;
-		nP[side] += 1.0f;
-
-		int wave = params[WAVE_PARAM + i].getValue();
-		switch(wave) {
-			case 0:		amp = oscillator[i].sine * attn;		break;
-			case 1:		amp = oscillator[i].saw * attn;			break;
-			case 2:		amp = oscillator[i].doubleSaw * attn;	break;
-			case 3:		amp = oscillator[i].square * attn;		break;
-			case 4:		amp = oscillator[i].even * attn;		break;
-			default:	amp = oscillator[i].sine * attn;		break;
-		};
+		pitch[i] = pitchFine + pitchCv; // 1V/OCT
+		pw[i] = params[PW_PARAM + i].getValue() + params[PWM_PARAM + i].getValue() * inputs[PW_INPUT + i].getVoltage() / 10.0f;
+
+		wave[i] = clamp((int)params[WAVE_PARAM + i].getValue(), 0, 4);
+	}
+
+	// Position of each unison voice across the stack, -1 to 1
+	float unisonOffset[MAX_UNISON];
+	for (int u = 0; u < unison; u++) {
+		unisonOffset[u] = (unison > 1) ? 2.0f * u / (unison - 1) - 1.0f : 0.0f;
+	}
+
+	int nVoices = NUM_PITCHES * unison;
+	int nGroups = (nVoices + 3) / 4;
+	float detuneV = unisonDetune / 1200.0f;
 
-		float newAngle = spread * params[PAN_PARAM + i].getValue();
-		if (newAngle != angle) {
-			angle = newAngle;
-			left  = SQRT2_2 * (cos(angle) - sin(angle));
-			right = SQRT2_2 * (cos(angle) + sin(angle));
+	for (int g = 0; g < nGroups; g++) {
+
+		simd::float_4 groupPitch = 0.0f;
+		simd::float_4 groupPw = 0.0f;
+		int waves = 0;
+
+		for (int j = 0; j < 4 && g * 4 + j < nVoices; j++) {
+			int v = g * 4 + j;
+			int i = v / unison;
+			groupPitch[j] = pitch[i] + detuneV * unisonOffset[v % unison];
+			groupPw[j] = pw[i];
+			waves |= WAVE_OUTPUTS[wave[i]];
+		}
+
+		if (engine == ENGINE_MINBLEP) {
+			oscillator[g].pw = groupPw;
+			oscillator[g].waves = waves;
+			oscillator[g].step(args.sampleTime, groupPitch);
+		} else {
+			tableOscillator[g].pw = groupPw;
+			tableOscillator[g].waves = waves;
+			tableOscillator[g].cubic = engine == ENGINE_TABLE_CUBIC;
+			tableOscillator[g].step(args.sampleTime, groupPitch);
 		}
+	}
+
+	// Detuned voices are roughly uncorrelated, so scale the stack by its rms to keep the level steady
+	float unisonGain = 1.0f / std::sqrt((float)unison);
+
+	for (int v = 0; v < nVoices; v++) {
 
-		out[0] += left * amp;
-		out[1] += right * amp;
+		int i = v / unison;
 
+		float amp;
+		if (engine == ENGINE_MINBLEP) {
+			amp = selectWave(oscillator[v / 4], v % 4, wave[i]);
+		} else {
+			amp = selectWave(tableOscillator[v / 4], v % 4, wave[i]);
+		}
+		amp *= params[ATTN_PARAM + i].getValue() * unisonGain;
+
+		// Unison voices fan out either side of the pitch's pan position
+		float newAngle = spread * clamp(params[PAN_PARAM + i].getValue() + UNISON_WIDTH * unisonOffset[v % unison], -POSMAX, POSMAX);
+		if (newAngle != angle[v]) {
+			angle[v] = newAngle;
+			left[v]  = SQRT2_2 * (cos(newAngle) - sin(newAngle));
+			right[v] = SQRT2_2 * (cos(newAngle) + sin(newAngle));
+		}
+
+		out[0] += left[v] * amp;
+		out[1] += right[v] * amp;
+
+	}
+
+	for (int i = 0; i < NUM_PITCHES; i++) {
+		nP[i % 2] += 1.0f;
 	}
 
 	if (nP[0] > 0.0f) {
@@ -196,6 +329,10 @@ void Chord::process(const ProcessArgs &args) {
 
 struct ChordWidget : ModuleWidget {
 
+	std::vector<MenuOption<int>> engineOptions;
+	std::vector<MenuOption<int>> unisonOptions;
+	std::vector<MenuOption<float>> detuneOptions;
+
 	ChordWidget(Chord *module) {
 		
 		setModule(module);
@@ -269,6 +406,110 @@ struct ChordWidget : ModuleWidget {
 		addOutput(createOutputCentered<gui::AHPort>(Vec(183.149, 363.566), module, Chord::OUT_OUTPUT + 0));
 		addOutput(createOutputCentered<gui::AHPort>(Vec(221.5, 363.566), module, Chord::OUT_OUTPUT + 1));
 
+		engineOptions.emplace_back(std::string("MinBLEP"), Chord::ENGINE_MINBLEP);
+		engineOptions.emplace_back(std::string("Wavetable, linear"), Chord::ENGINE_TABLE_LINEAR);
+		engineOptions.emplace_back(std::string("Wavetable, cubic"), Chord::ENGINE_TABLE_CUBIC);
+
+		for (int n = 1; n <= MAX_UNISON; n++) {
+			unisonOptions.emplace_back(std::to_string(n), n);
+		}
+
+		detuneOptions.emplace_back(std::string("5 cents"), 5.0f);
+		detuneOptions.emplace_back(std::string("10 cents"), 10.0f);
+		detuneOptions.emplace_back(std::string("20 cents"), 20.0f);
+		detuneOptions.emplace_back(std::string("35 cents"), 35.0f);
+		detuneOptions.emplace_back(std::string("50 cents"), 50.0f);
+
+	}
+
+	void appendContextMenu(Menu *menu) override {
+		Chord *chord = dynamic_cast<Chord*>(module);
+		assert(chord);
+
+		struct ChordMenu : MenuItem {
+			Chord *module;
+			ChordWidget *parent;
+		};
+
+		struct EngineItem : ChordMenu {
+			int engine;
+			void onAction(const rack::event::Action &e) override {
+				module->engine = engine;
+			}
+		};
+
+		struct EngineMenu : ChordMenu {
+			Menu *createChildMenu() override {
+				Menu *menu = new Menu;
+				for (auto opt: parent->engineOptions) {
+					EngineItem *item = createMenuItem<EngineItem>(opt.name, CHECKMARK(module->engine == opt.value));
+					item->module = module;
+					item->engine = opt.value;
+					menu->addChild(item);
+				}
+				return menu;
+			}
+		};
+
+		struct UnisonItem : ChordMenu {
+			int unison;
+			void onAction(const rack::event::Action &e) override {
+				module->unison = unison;
+			}
+		};
+
+		struct UnisonMenu : ChordMenu {
+			Menu *createChildMenu() override {
+				Menu *menu = new Menu;
+				for (auto opt: parent->unisonOptions) {
+					UnisonItem *item = createMenuItem<UnisonItem>(opt.name, CHECKMARK(module->unison == opt.value));
+					item->module = module;
+					item->unison = opt.value;
+					menu->addChild(item);
+				}
+				return menu;
+			}
+		};
+
+		struct DetuneItem : ChordMenu {
+			float detune;
+			void onAction(const rack::event::Action &e) override {
+				module->unisonDetune = detune;
+			}
+		};
+
+		struct DetuneMenu : ChordMenu {
+			Menu *createChildMenu() override {
+				Menu *menu = new Menu;
+				for (auto opt: parent->detuneOptions) {
+					DetuneItem *item = createMenuItem<DetuneItem>(opt.name, CHECKMARK(module->unisonDetune == opt.value));
+					item->module = module;
+					item->detune = opt.value;
+					menu->addChild(item);
+				}
+				return menu;
+			}
+		};
+
+		menu->addChild(construct<MenuLabel>());
+
+		EngineMenu *engineItem = createMenuItem<EngineMenu>("Oscillator engine");
+		engineItem->module = chord;
+		engineItem->parent = this;
+		menu->addChild(engineItem);
+
+		UnisonMenu *unisonItem = createMenuItem<UnisonMenu>("Unison voices");
+		unisonItem->module = chord;
+		unisonItem->parent = this;
+		menu->addChild(unisonItem);
+
+		DetuneMenu *detuneItem = createMenuItem<DetuneMenu>("Unison detune");
+		detuneItem->module = chord;
+		detuneItem->parent = this;
+		menu->addChild(detuneItem);
+
+		menu->addChild(gui::createFixedSeedItem(chord));
+
 	}
 
 };
@@ -12,7 +12,7 @@ struct Galaxy : core::AHModule {
 	const static int N_NOTES = 12;
 	const static int QMAP_SIZE = 20;
 
-	std::string degNames[42] { // Degree * 3 + Quality
+	const char *degNames[42] { // Degree * 3 + Quality
 		"I",
 		"I7",
 		"im7",
@@ -157,8 +157,6 @@ struct Galaxy : core::AHModule {
 
 	music::Chord currChord;
 
-	music::KnownChords knownChords;
-
 	music::RootScaling voltScale = music::RootScaling::CIRCLE;
 
 	int lastQuality = 0;
@@ -176,11 +174,8 @@ struct Galaxy : core::AHModule {
 	int mode = 1;				// 0 = random chord, 1 = chord in key, 2 = chord in mode
 	int allowedInversions = 0;	// 0 = root only, 1 = root + first, 2 = root, first, second
 
-	std::string rootName = "";
-	std::string modeName = "";
-
-	std::string chordName = "";
-	std::string chordExtName = "";
+	music::ChordLabel chordLabel;
+	int chordExt = -1; // Index into degNames
 };
 
 void Galaxy::process(const ProcessArgs &args) {
@@ -211,18 +206,6 @@ void Galaxy::process(const ProcessArgs &args) {
 		currRoot = params[KEY_PARAM].getValue();
 	}
 
-	if (mode == 1) {
-		rootName = music::noteNames[currRoot];
-		modeName = "";
-	} else if (mode == 2) {
-		rootName = music::NoteDegreeModeNames[currRoot][0][currMode];
-		modeName = music::modeNames[currMode];
-	} else {
-		rootName = "";
-		modeName = "";
-		chordExtName = "";
-	}
-
 	if (move) {
 
 		bool changed = false;
@@ -232,7 +215,7 @@ void Galaxy::process(const ProcessArgs &args) {
 			getFromRandom();
 		} else if (mode == 1) {
 
-			if (random::uniform() < params[BAD_PARAM].getValue()) {
+			if (rng.uniform() < params[BAD_PARAM].getValue()) {
 				badLight = 2;
 				getFromRandom();
 			} else {
@@ -241,7 +224,7 @@ void Galaxy::process(const ProcessArgs &args) {
 
 		} else if (mode == 2) {
 
-			float excess = params[BAD_PARAM].getValue() - random::uniform();
+			float excess = params[BAD_PARAM].getValue() - rng.uniform();
 
 			if (excess < 0.0) {
 				getFromKeyMode();
@@ -258,11 +241,11 @@ void Galaxy::process(const ProcessArgs &args) {
 
 		}
 
-		currChord.inversion = InversionMap[allowedInversions][rand() % QMAP_SIZE];
+		currChord.inversion = InversionMap[allowedInversions][rng.integer(QMAP_SIZE)];
 		currChord.chord = GalaxyChords[currChord.quality];
-		const ah::music::InversionDefinition & invDef = knownChords.getChord(currChord);
+		const ah::music::InversionDefinition & invDef = music::knownChords.getChord(currChord);
 	
-		currChord.setVoltages(invDef.formula, offset);
+		currChord.setVoltages(invDef, offset, rng);
 
 		if (currChord.quality != lastQuality) {
 			changed = true;
@@ -285,15 +268,15 @@ void Galaxy::process(const ProcessArgs &args) {
 
 			if (mode == 2) {
 				if (haveMode) {
-					chordName = invDef.getName(currMode, currRoot, currChord.modeDegree, currChord.rootNote);
-					chordExtName = degNames[currChord.modeDegree * 6 + currChord.quality];
+					chordLabel.set(invDef, currMode, currRoot, currChord.modeDegree, currChord.rootNote);
+					chordExt = currChord.modeDegree * 6 + currChord.quality;
 				} else {
-					chordName = invDef.getName(currChord.rootNote);
-					chordExtName = "";
+					chordLabel.set(invDef, currChord.rootNote);
+					chordExt = -1;
 				} 
 			} else {
-				chordName = invDef.getName(currChord.rootNote);
-				chordExtName = "";
+				chordLabel.set(invDef, currChord.rootNote);
+				chordExt = -1;
 			}
 
 			lights[NOTE_LIGHT + light].setBrightness(0.0f);
@@ -324,18 +307,18 @@ void Galaxy::process(const ProcessArgs &args) {
 
 }
 
-signed short rndSign() {
-	return rand() % 2 ? 1 : -1;
+signed short rndSign(core::Random &rng) {
+	return rng.integer(2) ? 1 : -1;
 }
 
-signed int signedRndNotZero(signed int magntiude) {
-	return rndSign() * (rand() % abs(magntiude) + 1); 
+signed int signedRndNotZero(signed int magntiude, core::Random &rng) {
+	return rndSign(rng) * (rng.integer(abs(magntiude)) + 1); 
 }
 
 void Galaxy::getFromRandom() {
 
-	int rotateInput = signedRndNotZero(2);
-	int radialInput = signedRndNotZero(2);
+	int rotateInput = signedRndNotZero(2, rng);
+	int radialInput = signedRndNotZero(2, rng);
 
 	if(debugEnabled(5000)) {
 		std::cout << "Rotate: " << rotateInput << "  Radial: " << radialInput << std::endl;
@@ -352,8 +335,8 @@ void Galaxy::getFromRandom() {
 
 void Galaxy::getFromKey() {
 
-	int rotateInput = signedRndNotZero(2);
-	int radialInput = signedRndNotZero(2);
+	int rotateInput = signedRndNotZero(2, rng);
+	int radialInput = signedRndNotZero(2, rng);
 
 	if(debugEnabled(5000)) {
 		std::cout << "Rotate: " << rotateInput << "  Radial: " << radialInput << std::endl;
@@ -364,7 +347,7 @@ void Galaxy::getFromKey() {
 	currChord.quality = eucMod(currChord.quality, N_QUALITIES);
 
 	// Just major scale
-	int *curScaleArr = music::ASCALE_IONIAN;
+	const int *curScaleArr = music::ASCALE_IONIAN;
 	int notesInScale = LENGTHOF(music::ASCALE_IONIAN);
 
 	// Determine move through the scale
@@ -377,7 +360,7 @@ void Galaxy::getFromKey() {
 
 void Galaxy::getFromKeyMode() {
 
-	int rotateInput = signedRndNotZero(2);
+	int rotateInput = signedRndNotZero(2, rng);
 
 	// Determine move through the scale
 	currChord.modeDegree += rotateInput;
@@ -386,7 +369,7 @@ void Galaxy::getFromKeyMode() {
 	// From the input root, mode and degree, we can get the root chord note and quality (Major,Minor,Diminshed)
 	int q;
 	music::getRootFromMode(currMode,currRoot,currChord.modeDegree,&(currChord.rootNote),&q);
-	currChord.quality = QualityMap[q][rand() % QMAP_SIZE];
+	currChord.quality = QualityMap[q][rng.integer(QMAP_SIZE)];
 
 }
 
@@ -416,18 +399,21 @@ struct GalaxyDisplay : TransparentWidget {
 
 			char text[128];
 
-			snprintf(text, sizeof(text), "%s", module->chordName.c_str());
+			module->chordLabel.format(text, sizeof(text));
 			nvgText(ctx.vg, box.pos.x + 5, box.pos.y, text, NULL);
 
-			snprintf(text, sizeof(text), "%s", module->chordExtName.c_str());
-			nvgText(ctx.vg, box.pos.x + 5, box.pos.y + 11, text, NULL);
+			int chordExt = module->chordExt;
+			if (module->mode == 2 && chordExt >= 0) {
+				nvgText(ctx.vg, box.pos.x + 5, box.pos.y + 11, module->degNames[chordExt], NULL);
+			}
 
 			nvgTextAlign(ctx.vg, NVG_ALIGN_RIGHT);
-			snprintf(text, sizeof(text), "%s", module->rootName.c_str());
-			nvgText(ctx.vg, box.size.x - 5, box.pos.y, text, NULL);
-
-			snprintf(text, sizeof(text), "%s", module->modeName.c_str());
-			nvgText(ctx.vg, box.size.x - 5, box.pos.y + 11, text, NULL);
+			if (module->mode == 1) {
+				nvgText(ctx.vg, box.size.x - 5, box.pos.y, music::noteNames[module->currRoot], NULL);
+			} else if (module->mode == 2) {
+				nvgText(ctx.vg, box.size.x - 5, box.pos.y, music::NoteDegreeModeNames[module->currRoot][0][module->currMode], NULL);
+				nvgText(ctx.vg, box.size.x - 5, box.pos.y + 11, music::modeNames[module->currMode], NULL);
+			}
 		}
 
 	}
@@ -622,6 +608,8 @@ struct GalaxyWidget : ModuleWidget {
 		scaleItem->parent = this;
 		menu->addChild(scaleItem);
 
+		menu->addChild(gui::createFixedSeedItem(galaxy));
+
 	}
 
 };
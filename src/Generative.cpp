@@ -1,4 +1,4 @@
-#include "dsp/noise.hpp"
+#include "dsp/blocknoise.hpp"
 
 #include "AH.hpp"
 #include "AHCommon.hpp"
@@ -139,6 +139,8 @@ struct Generative : core::AHModule {
 
 		configParam(ATTN_PARAM, 0.0, 1.0, 1.0, "Level", "%", 0.0f, 100.0f);
 
+		reseed();
+
 	}
 
 	void process(const ProcessArgs &args) override;
@@ -154,6 +156,9 @@ struct Generative : core::AHModule {
 		json_t *offsetJ = json_boolean(offset);
 		json_object_set_new(rootJ, "offset", offsetJ);
 
+		// channels
+		json_object_set_new(rootJ, "channels", json_integer(polyChannels));
+
 		return rootJ;
 	}
 
@@ -165,34 +170,44 @@ struct Generative : core::AHModule {
 		// offset
 		json_t *offsetJ = json_object_get(rootJ, "offset");
 		if (offsetJ) offset = json_boolean_value(offsetJ);
+
+		// channels
+		json_t *channelsJ = json_object_get(rootJ, "channels");
+		if (channelsJ) polyChannels = clamp((int)json_integer_value(channelsJ), 1, 16);
 	}
 
-	rack::dsp::SchmittTrigger sampleTrigger;
-	rack::dsp::SchmittTrigger holdTrigger;
-	rack::dsp::SchmittTrigger clockTrigger;
-	bogaudio::dsp::PinkNoiseGenerator pink;
-	LowFrequencyOscillator oscillator;
-	LowFrequencyOscillator clock;
-	digital::AHPulseGenerator delayPhase;
-	digital::AHPulseGenerator gatePhase;
-
-	float target = 0.0f;
-	float current = 0.0f;
+	// Voices run four to a simd::float_4, one entry per group of four channels
+	rack::dsp::TSchmittTrigger<simd::float_4> sampleTrigger[4];
+	rack::dsp::TSchmittTrigger<simd::float_4> clockTrigger[4];
+	noise::PinkNoise4 pink[4];
+
+	void onReseed() override {
+		for (int g = 0; g < 4; g++) {
+			pink[g].seed(rng.next());
+		}
+	}
+	LowFrequencyOscillator<simd::float_4> oscillator[4];
+	LowFrequencyOscillator<simd::float_4> clock[4];
+	digital::AHPulseGenerator4 delayPhase[4];
+	digital::AHPulseGenerator4 gatePhase[4];
+
+	simd::float_4 target[4] = {};
+	digital::SlewLimiter<simd::float_4> slew[4];
+	simd::float_4 delayState[4] = {}; // Lane mask
 	bool quantise = false;
 	bool offset = false;
-	bool delayState = false;
-	bool gateState = false;
-
-	// minimum and maximum slopes in volts per second
-	const float slewMin = 0.1f;
-	const float slewMax = 10000.0f;
-	const float slewRatio = slewMin / slewMax;
 
-	// Amount of extra slew per voltage difference
-	const float shapeScale = 1.0f / 10.0;
+	// Voices when no input is polyphonic; a polyphonic input with more channels takes over
+	int polyChannels = 1;
 
-	float delayTime;
-	float gateTime;
+	int getChannels() {
+		int channels = polyChannels;
+		const int polyInputs[] = {FM_INPUT, AM_INPUT, WAVE_INPUT, NOISE_INPUT, SAMPLE_INPUT, CLOCK_INPUT, PROB_INPUT, HOLD_INPUT};
+		for (int id : polyInputs) {
+			channels = std::max(channels, inputs[id].getChannels());
+		}
+		return channels;
+	}
 
 };
 
@@ -200,164 +215,163 @@ void Generative::process(const ProcessArgs &args) {
 
 	AHModule::step();
 
-	oscillator.setPitch(params[FREQ_PARAM].getValue() + params[FM_PARAM].getValue() * inputs[FM_INPUT].getVoltage());
-	oscillator.offset = offset;
-	oscillator.step(args.sampleTime);
+	int channels = getChannels();
 
-	clock.setPitch(clamp(params[CLOCK_PARAM].getValue() + inputs[CLOCK_INPUT].getVoltage(), -2.0f, 6.0f));
-	clock.step(args.sampleTime);
+	float freqParam = params[FREQ_PARAM].getValue();
+	float fmParam = params[FM_PARAM].getValue();
+	float amParam = params[AM_PARAM].getValue();
+	float waveParam = params[WAVE_PARAM].getValue();
+	float noiseParam = params[NOISE_PARAM].getValue();
+	float clockParam = params[CLOCK_PARAM].getValue();
+	float probParam = params[PROB_PARAM].getValue();
+	float range = params[ATTN_PARAM].getValue();
+	float shape = params[SLOPE_PARAM].getValue();
+	float speed = params[SPEED_PARAM].getValue();
 
-	float wavem = fabs(fmodf(params[WAVE_PARAM].getValue() + inputs[WAVE_INPUT].getVoltage(), 4.0f));
+	bool sampleActive = inputs[SAMPLE_INPUT].isConnected();
+	bool amActive = inputs[AM_INPUT].isConnected();
 
-	float interp = 0.0f;
-	bool toss = false;
+	bool gateLight = false;
+	bool delayLight = false;
 
-	if (wavem < 1.0f) {
-		interp = crossfade(oscillator.sin(), oscillator.tri(), wavem) * 5.0f; 
-	} else if (wavem < 2.0f) {
-		interp = crossfade(oscillator.tri(), oscillator.saw(), wavem - 1.0f) * 5.0f;
-	} else if (wavem < 3.0f) {
-		interp = crossfade(oscillator.saw(), oscillator.sqr(), wavem - 2.0f) * 5.0f;
-	} else {
-		interp = crossfade(oscillator.sqr(), oscillator.sin(), wavem - 3.0f) * 5.0f;
-	}
+	for (int c = 0; c < channels; c += 4) {
+		int g = c / 4;
 
-	// Capture (pink) noise
-	float noise = clamp(pink.next() * 7.5f, -5.0f, 5.0f); // -5V to 5V
-	float range = params[ATTN_PARAM].getValue();
+		oscillator[g].setPitch(freqParam + fmParam * inputs[FM_INPUT].getPolyVoltageSimd<simd::float_4>(c));
+		oscillator[g].offset = offset;
+		oscillator[g].step(args.sampleTime);
 
-	// Shift the noise floor
-	if (offset) {
-		noise += 5.0f;
-	}
+		clock[g].setPitch(simd::clamp(clockParam + inputs[CLOCK_INPUT].getPolyVoltageSimd<simd::float_4>(c), -2.0f, 6.0f));
+		clock[g].step(args.sampleTime);
 
-	float noiseLevel = clamp(params[NOISE_PARAM].getValue() + inputs[NOISE_INPUT].getVoltage(), 0.0f, 1.0f);
+		simd::float_4 wavem = simd::fabs(simd::fmod(waveParam + inputs[WAVE_INPUT].getPolyVoltageSimd<simd::float_4>(c), 4.0f));
 
-	// Mixed the input AM signal or noise
-	if (inputs[AM_INPUT].isConnected()) {
-		interp = crossfade(interp, inputs[AM_INPUT].getVoltage(), params[AM_PARAM].getValue()) * range;
-	} else {
-		interp *= range;
-	}
+		// All four shapes, then pick the segment each lane's morph is in
+		simd::float_4 sine = oscillator[g].sin();
+		simd::float_4 tri = oscillator[g].tri();
+		simd::float_4 saw = oscillator[g].saw();
+		simd::float_4 sqr = oscillator[g].sqr();
 
-	// Mix noise
-	float mixedSignal = (noise * noiseLevel + interp * (1.0f - noiseLevel));
+		simd::float_4 interp = simd::ifelse(wavem < 1.0f, sine + (tri - sine) * wavem,
+			simd::ifelse(wavem < 2.0f, tri + (saw - tri) * (wavem - 1.0f),
+			simd::ifelse(wavem < 3.0f, saw + (sqr - saw) * (wavem - 2.0f),
+			sqr + (sine - sqr) * (wavem - 3.0f)))) * 5.0f;
 
-	// Process gate
-	bool sampleActive = inputs[SAMPLE_INPUT].isConnected();
-	float sample = inputs[SAMPLE_INPUT].getVoltage();
-	bool hold = inputs[HOLD_INPUT].getVoltage() > 0.000001f;
+		// Capture (pink) noise
+		simd::float_4 noise = simd::clamp(pink[g].next() * 7.5f, -5.0f, 5.0f); // -5V to 5V
+
+		// Shift the noise floor
+		if (offset) {
+			noise += 5.0f;
+		}
 
-	bool isClocked = false;
+		simd::float_4 noiseLevel = simd::clamp(noiseParam + inputs[NOISE_INPUT].getPolyVoltageSimd<simd::float_4>(c), 0.0f, 1.0f);
 
-	if (!sampleActive) {
-		if (clockTrigger.process(clock.sqr())) {
-			isClocked = true;
+		// Mixed the input AM signal or noise
+		if (amActive) {
+			simd::float_4 am = inputs[AM_INPUT].getPolyVoltageSimd<simd::float_4>(c);
+			interp = (interp + (am - interp) * amParam) * range;
+		} else {
+			interp *= range;
 		}
-	} else {
-		if (sampleTrigger.process(sample)) {
-			isClocked = true;
+
+		// Mix noise
+		simd::float_4 mixedSignal = noise * noiseLevel + interp * (1.0f - noiseLevel);
+
+		// Process gate
+		simd::float_4 isClocked;
+		if (!sampleActive) {
+			isClocked = clockTrigger[g].process(clock[g].sqr());
+		} else {
+			isClocked = sampleTrigger[g].process(inputs[SAMPLE_INPUT].getPolyVoltageSimd<simd::float_4>(c));
 		}
-	}
 
-	// If we have no input or we have been a trigger on the sample input
-	if (isClocked) {
+		simd::float_4 hold = inputs[HOLD_INPUT].getPolyVoltageSimd<simd::float_4>(c) > 0.000001f;
 
-		// If we are not in a delay or gate state process the tick, otherwise eat it
-		if (!delayPhase.ishigh() && !gatePhase.ishigh()) {
+		// If we are not in a delay or gate state process the tick, otherwise eat it.
+		// Ticks are rare, so the toss and the delay draw are done lane by lane
+		int ticks = simd::movemask(isClocked & ~(delayPhase[g].ishigh() | gatePhase[g].ishigh()));
+		if (ticks) {
 
 			// Check against prob control
-			float threshold = clamp(params[PROB_PARAM].getValue() + inputs[PROB_INPUT].getVoltage() / 10.f, 0.0f, 1.0f);
-			toss = (random::uniform() < threshold);
-
-			// Tick is valid
-			if (toss) {
-
-				// Determine delay time
-				float dlyLen = log2(params[DELAYL_PARAM].getValue());
-				float dlySpr = log2(params[DELAYS_PARAM].getValue());
-
-				double rndD = clamp(random::normal(), -2.0f, 2.0f);
-				delayTime = clamp(dlyLen + dlySpr * rndD, 0.0f, 100.0f);
-				
-				// Trigger the respective delay pulse generator
-				delayState = true;
-				delayPhase.trigger(delayTime);
+			simd::float_4 threshold = simd::clamp(probParam + inputs[PROB_INPUT].getPolyVoltageSimd<simd::float_4>(c) / 10.f, 0.0f, 1.0f);
+
+			// Determine delay time
+			float dlyLen = log2(params[DELAYL_PARAM].getValue());
+			float dlySpr = log2(params[DELAYS_PARAM].getValue());
+
+			int tossed = 0;
+			simd::float_4 delayTime = 0.0f;
+			for (int i = 0; i < 4; i++) {
+				if ((ticks & (1 << i)) && rng.uniform() < threshold[i]) {
+					delayTime[i] = clamp(dlyLen + dlySpr * clamp(rng.normal(), -2.0f, 2.0f), 0.0f, 100.0f);
+					tossed |= 1 << i;
+				}
 			}
-		}
-	}
-
-	// In delay state and finished waiting
-	if (delayState && !delayPhase.process(args.sampleTime)) {
-
-		// set the target voltage
-		target = mixedSignal;
 
-		// Determine gate time
-		float gateLen = log2(params[GATEL_PARAM].getValue());
-		float gateSpr = log2(params[GATES_PARAM].getValue());
+			// Trigger the respective delay pulse generators
+			simd::float_4 tossMask = digital::laneMask(tossed);
+			delayState[g] = delayState[g] | tossMask;
+			delayPhase[g].trigger(tossMask, delayTime);
+		}
 
-		double rndG = clamp(random::normal(), -2.0f, 2.0f);
-		gateTime = clamp(gateLen + gateSpr * rndG, digital::TRIGGER, 100.0f);
+		// In delay state and finished waiting
+		int ended = simd::movemask(delayState[g] & ~delayPhase[g].process(args.sampleTime));
+		if (ended) {
 
-		// Open the gate and set flags
-		gatePhase.trigger(gateTime);
-		gateState = true;
-		delayState = false;
-	}
+			// set the target voltage
+			simd::float_4 endMask = digital::laneMask(ended);
+			target[g] = simd::ifelse(endMask, mixedSignal, target[g]);
 
-	// If not held slew voltages
-	if (!hold) {
+			// Determine gate time
+			float gateLen = log2(params[GATEL_PARAM].getValue());
+			float gateSpr = log2(params[GATES_PARAM].getValue());
 
-		// Curve calc
-		float shape = params[SLOPE_PARAM].getValue();
-		float speed = params[SPEED_PARAM].getValue();	
-		float slew = slewMax * powf(slewRatio, speed);
+			simd::float_4 gateTime = 0.0f;
+			for (int i = 0; i < 4; i++) {
+				if (ended & (1 << i)) {
+					gateTime[i] = clamp(gateLen + gateSpr * clamp(rng.normal(), -2.0f, 2.0f), digital::TRIGGER, 100.0f);
+				}
+			}
 
-		// Rise
-		if (target > current) {
-			current += slew * crossfade(1.0f, shapeScale * (target - current), shape) * args.sampleTime;
-			if (current > target) // Trap overshoot
-				current = target;
+			// Open the gate and clear the delay
+			gatePhase[g].trigger(endMask, gateTime);
+			delayState[g] = delayState[g] & ~endMask;
 		}
-		// Fall
-		else if (target < current) {
-			current -= slew * crossfade(1.0f, shapeScale * (current - target), shape) * args.sampleTime;
-			if (current < target) // Trap overshoot
-				current = target;
-		}
-	}
 
-	// If the gate is open, set output to high
-	if (gatePhase.process(args.sampleTime)) {
-		outputs[GATE_OUTPUT].setVoltage(10.0f);
+		// If not held slew voltages; a held lane's target is where it already is
+		slew[g].setParams(speed, shape, args.sampleTime);
+		simd::float_4 current = slew[g].process(simd::ifelse(hold, slew[g].value, target[g]));
 
-		lights[GATE_LIGHT].setSmoothBrightness(1.0f, args.sampleTime);
-		lights[GATE_LIGHT + 1].setSmoothBrightness(0.0f, args.sampleTime);
+		// If the gate is open, set output to high
+		simd::float_4 gate = gatePhase[g].process(args.sampleTime);
+		outputs[GATE_OUTPUT].setVoltageSimd(simd::ifelse(gate, 10.0f, 0.0f), c);
 
-	} else {
-		outputs[GATE_OUTPUT].setVoltage(0.0f);
-		gateState = false;
+		if (g == 0) {
+			gateLight = gate[0] != 0.0f;
+			delayLight = delayState[0][0] != 0.0f;
+		}
 
-		if (delayState) {
-			lights[GATE_LIGHT].setSmoothBrightness(0.0f, args.sampleTime);
-			lights[GATE_LIGHT + 1].setSmoothBrightness(1.0f, args.sampleTime);
-		} else {
-			lights[GATE_LIGHT].setSmoothBrightness(0.0f, args.sampleTime);
-			lights[GATE_LIGHT + 1].setSmoothBrightness(0.0f, args.sampleTime);
+		simd::float_4 out = current;
+		if (quantise) {
+			for (int i = 0; i < 4; i++) {
+				out[i] = music::getPitchFromVolts(out[i], music::Notes::NOTE_C, music::Scales::SCALE_CHROMATIC);
+			}
 		}
 
+		outputs[OUT_OUTPUT].setVoltageSimd(out, c);
+		outputs[NOISE_OUTPUT].setVoltageSimd(noise * 2.0f, c);
+		outputs[LFO_OUTPUT].setVoltageSimd(interp, c);
+		outputs[MIXED_OUTPUT].setVoltageSimd(mixedSignal, c);
 	}
 
-	if (quantise) {
-		outputs[OUT_OUTPUT].setVoltage(music::getPitchFromVolts(current, music::Notes::NOTE_C, music::Scales::SCALE_CHROMATIC));
-	} else {
-		outputs[OUT_OUTPUT].setVoltage(current);
+	for (int i = 0; i < NUM_OUTPUTS; i++) {
+		outputs[i].setChannels(channels);
 	}
-	
-	outputs[NOISE_OUTPUT].setVoltage(noise * 2.0);
-	outputs[LFO_OUTPUT].setVoltage(interp);
-	outputs[MIXED_OUTPUT].setVoltage(mixedSignal);
+
+	// Lights follow the first voice
+	lights[GATE_LIGHT].setSmoothBrightness(gateLight ? 1.0f : 0.0f, args.sampleTime);
+	lights[GATE_LIGHT + 1].setSmoothBrightness(!gateLight && delayLight ? 1.0f : 0.0f, args.sampleTime);
 
 }
 
@@ -365,6 +379,7 @@ struct GenerativeWidget : ModuleWidget {
 	
 	std::vector<MenuOption<bool>> quantiseOptions;
 	std::vector<MenuOption<bool>> offsetOptions;
+	std::vector<MenuOption<int>> channelOptions;
 
 	GenerativeWidget(Generative *module) {
 
@@ -409,6 +424,10 @@ struct GenerativeWidget : ModuleWidget {
 		offsetOptions.emplace_back(std::string("0V - 10V"), true);
 		offsetOptions.emplace_back(std::string("-5V to 5V"), false);
 
+		for (int i = 1; i <= 16; i++) {
+			channelOptions.emplace_back(std::to_string(i), i);
+		}
+
 	}
 
 	void appendContextMenu(Menu *menu) override {
@@ -460,6 +479,26 @@ struct GenerativeWidget : ModuleWidget {
 			}
 		};
 
+		struct ChannelItem : GenerativeMenu {
+			int channels;
+			void onAction(const rack::event::Action &e) override {
+				module->polyChannels = channels;
+			}
+		};
+
+		struct ChannelMenu : GenerativeMenu {
+			Menu *createChildMenu() override {
+				Menu *menu = new Menu;
+				for (auto opt: parent->channelOptions) {
+					ChannelItem *item = createMenuItem<ChannelItem>(opt.name, CHECKMARK(module->polyChannels == opt.value));
+					item->module = module;
+					item->channels = opt.value;
+					menu->addChild(item);
+				}
+				return menu;
+			}
+		};
+
 		menu->addChild(construct<MenuLabel>());
 
 		QuantiseMenu *quantiseItem = createMenuItem<QuantiseMenu>("Quantise");
@@ -472,6 +511,13 @@ struct GenerativeWidget : ModuleWidget {
 		offsetItem->parent = this;
 		menu->addChild(offsetItem);
 
+		ChannelMenu *channelItem = createMenuItem<ChannelMenu>("Polyphony channels");
+		channelItem->module = gen;
+		channelItem->parent = this;
+		menu->addChild(channelItem);
+
+		menu->addChild(gui::createFixedSeedItem(gen));
+
 	}
 };
 
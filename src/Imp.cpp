@@ -123,7 +123,7 @@ void Imp::process(const ProcessArgs &args) {
 		counter++;
 
 		// Check clock division and Bern. gate
-		if ((counter % setting.division == 0) && (random::uniform() < params[PROB_PARAM].getValue())) { 
+		if ((counter % setting.division == 0) && (rng.uniform() < params[PROB_PARAM].getValue())) { 
 
 			// check that we are not in the gate phase
 			if (!coreState.gatePhase.ishigh() && !coreState.delayPhase.ishigh()) {
@@ -139,6 +139,10 @@ void Imp::process(const ProcessArgs &args) {
 
 			}
 
+			// Delay and gate deviations for every channel in one draw
+			float rnd[32];
+			rng.normal(rnd, 32);
+
 			for (int i = 0; i < 16; i++) {
 
 				// check that we are not in the gate phase
@@ -148,7 +152,7 @@ void Imp::process(const ProcessArgs &args) {
 						// Non-randomised delay and gate length
 						state[i].fixed(coreState.delayTime, coreState.gateTime);	
 					} else {
-						state[i].jitter(setting);
+						state[i].jitter(setting, rnd[i], rnd[16 + i]);
 					}
 
 					// Trigger the respective delay pulse generator
@@ -342,6 +346,8 @@ struct ImpWidget : ModuleWidget {
 		randomZeroItem->parent = this;
 		menu->addChild(randomZeroItem);
 
+		menu->addChild(gui::createFixedSeedItem(imp));
+
 	}
 
 };
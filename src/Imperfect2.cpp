@@ -146,7 +146,7 @@ void Imperfect2::process(const ProcessArgs &args) {
 				if (!state[i].gatePhase.ishigh() && !state[i].delayPhase.ishigh()) {
 
 					// Generate randomised times
-					state[i].jitter(setting[i]);
+					state[i].jitter(setting[i], rng);
 
 					// Trigger the respective delay pulse generator
 					state[i].delayState = true;
@@ -367,6 +367,16 @@ struct Imperfect2Widget : ModuleWidget {
 			}
 		}
 	}
+
+	void appendContextMenu(Menu *menu) override {
+
+		Imperfect2 *imp = dynamic_cast<Imperfect2*>(module);
+		assert(imp);
+
+		menu->addChild(construct<MenuLabel>());
+		menu->addChild(gui::createFixedSeedItem(imp));
+
+	}
 };
 
 Model *modelImperfect2 = createModel<Imperfect2, Imperfect2Widget>("Imperfect2");
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <array>
 #include <string.h>
 #include <osdialog.h>
@@ -7,7 +8,17 @@
 
 #include <iostream>
 
-static const int BUFFER_SIZE = 512;
+static const int SWEEP_POINTS = 512; // Sweep length in units of the time setting
+static const int BUFFER_SIZE = 2048; // Min/max buckets captured per sweep
+static const int PUBLISH_SAMPLES = 1024; // Longest time a slow sweep goes without being published to the display
+static const int RING_SIZE = 4096; // Buckets of continuous capture per history level, room for a full sweep plus its pre-trigger
+static const int HISTORY_LEVELS = 4; // Ring levels, each bucket of a level spanning HISTORY_RATIO of the level below
+static const int HISTORY_SHIFT = 2;
+static const int HISTORY_RATIO = 1 << HISTORY_SHIFT;
+static const int MAX_CAPTURED = RING_SIZE << (HISTORY_SHIFT * (HISTORY_LEVELS - 1)); // Finest buckets the coarsest level holds
+static const int FFT_SIZE = 2048; // Raw samples per spectrum frame
+static const float AUTO_TIME = 0.1f; // How long auto mode waits for a trigger before free-running
+static const float TRIGGER_HYSTERESIS = 0.1f;
 
 using namespace ah;
 
@@ -36,18 +47,88 @@ struct PolyScope : core::AHModule {
 		NUM_LIGHTS
 	};
 
-	float buffer[16][BUFFER_SIZE] = {};
-	int bufferIndex = 0;
-	float frameIndex = 0;
-	int maxChannels = 0;
+	// Each bucket holds the extremes of every sample captured in it, so peaks between buckets are never lost
+	struct ScopeFrame {
+		float min[16][BUFFER_SIZE];
+		float max[16][BUFFER_SIZE];
+		int channels;
+		int start; // First bucket holding signal; history from before capture began is left empty
+		int length; // Buckets captured so far in this sweep
+		unsigned int sweep;
+		unsigned int generation; // Changes on every publish, so the display knows when to redraw
+	};
+
+	enum DisplayMode {
+		DISPLAY_SCOPE,
+		DISPLAY_SPECTRUM,
+		DISPLAY_PERSISTENCE
+	};
+
+	enum TriggerMode {
+		TRIGGER_AUTO, // Free-runs if no trigger arrives within AUTO_TIME
+		TRIGGER_NORMAL,
+		TRIGGER_SINGLE
+	};
+
+	enum SweepState {
+		SWEEP_HOLDOFF,
+		SWEEP_ARMED,
+		SWEEP_CAPTURING,
+		SWEEP_STOPPED
+	};
 
+	// Raw samples for the spectrum display; the FFT itself runs on the UI thread
+	struct SpectrumFrame {
+		float samples[16][FFT_SIZE];
+		int channels;
+		float sampleRate;
+		unsigned int generation;
+	};
+
+	core::SnapshotBuffer<ScopeFrame> frames;
+	core::SnapshotBuffer<SpectrumFrame> spectra;
+	int spectrumPos = 0;
+	unsigned int spectrumGeneration = 0;
+	float bucketPos = 0.0f;
+	bool bucketEmpty = true;
+	int publishCount = 0;
+	unsigned int sweep = 0;
+	unsigned int generation = 0;
+
+	simd::float_4 bucketMin[4] = {};
+	simd::float_4 bucketMax[4] = {};
+
+	// Capture never stops; buckets go into the ring and sweeps are cut from it. Level 0 holds the buckets of a sweep,
+	// each coarser level merges HISTORY_RATIO buckets of the one below, so keeps HISTORY_RATIO times the history
+	float ringMin[HISTORY_LEVELS][16][RING_SIZE];
+	float ringMax[HISTORY_LEVELS][16][RING_SIZE];
+	unsigned int ringPos = 0; // Level 0 buckets captured since start, wraps with the ring
+	unsigned int sweepStart = 0;
+	int sweepLevel = 0; // History level the current sweep is shown from
+	int ringChannels = 0;
+	int ringCaptured[16] = {}; // Level 0 buckets that hold each channel's signal, up to MAX_CAPTURED
+
+	SweepState sweepState = SWEEP_HOLDOFF;
+	float stateTime = 0.0f;
+	std::atomic<bool> rearmRequested {false}; // Set from the UI thread, taken by process()
+
+	// Trigger settings
+	int triggerMode = TRIGGER_AUTO;
+	int triggerChannel = 0;
+	float triggerLevel = 0.0f;
+	bool triggerFalling = false;
+	float holdoff = 0.0f;
+	float preTrigger = 0.0f; // Fraction of the sweep shown before the trigger
+	int history = 0; // The display shows HISTORY_RATIO^history sweeps, ending with the current one
+
+	int displayMode = DISPLAY_SCOPE;
 	bool toggle = false;
 
 	int currCMap = 1;
 	std::string path;
 	std::string directory;
 
-	dsp::SchmittTrigger resetTrigger;
+	dsp::SchmittTrigger trigger;
 
 	void loadCMap(const char *path) {
 
@@ -171,6 +252,8 @@ struct PolyScope : core::AHModule {
 			cMaps[5][i] = nvgRGBf(1.0f, 1.0f, 1.0f); // User defined, start with all white
 		}
 
+		clearRing();
+
 	}
 
 	json_t *dataToJson() override {
@@ -179,6 +262,15 @@ struct PolyScope : core::AHModule {
 		json_object_set_new(rootJ, "cmap", json_integer((int) currCMap));
 		json_object_set_new(rootJ, "path", json_string(path.c_str()));
 
+		json_object_set_new(rootJ, "displayMode", json_integer(displayMode));
+		json_object_set_new(rootJ, "triggerMode", json_integer(triggerMode));
+		json_object_set_new(rootJ, "triggerChannel", json_integer(triggerChannel));
+		json_object_set_new(rootJ, "triggerLevel", json_real(triggerLevel));
+		json_object_set_new(rootJ, "triggerFalling", json_boolean(triggerFalling));
+		json_object_set_new(rootJ, "holdoff", json_real(holdoff));
+		json_object_set_new(rootJ, "preTrigger", json_real(preTrigger));
+		json_object_set_new(rootJ, "history", json_integer(history));
+
 		return rootJ;
 	}
 
@@ -190,58 +282,249 @@ struct PolyScope : core::AHModule {
 		json_t *pathJ = json_object_get(rootJ, "path");
 		if (pathJ) loadCMap(json_string_value(pathJ));
 
+		json_t *displayModeJ = json_object_get(rootJ, "displayMode");
+		if (displayModeJ) displayMode = clamp((int)json_integer_value(displayModeJ), 0, 2);
+
+		// trigger
+		json_t *triggerModeJ = json_object_get(rootJ, "triggerMode");
+		if (triggerModeJ) triggerMode = clamp((int)json_integer_value(triggerModeJ), 0, 2);
+
+		json_t *triggerChannelJ = json_object_get(rootJ, "triggerChannel");
+		if (triggerChannelJ) triggerChannel = clamp((int)json_integer_value(triggerChannelJ), 0, 15);
+
+		json_t *triggerLevelJ = json_object_get(rootJ, "triggerLevel");
+		if (triggerLevelJ) triggerLevel = json_number_value(triggerLevelJ);
+
+		json_t *triggerFallingJ = json_object_get(rootJ, "triggerFalling");
+		if (triggerFallingJ) triggerFalling = json_boolean_value(triggerFallingJ);
+
+		json_t *holdoffJ = json_object_get(rootJ, "holdoff");
+		if (holdoffJ) holdoff = json_number_value(holdoffJ);
+
+		json_t *preTriggerJ = json_object_get(rootJ, "preTrigger");
+		if (preTriggerJ) preTrigger = clamp((float)json_number_value(preTriggerJ), 0.0f, 0.5f);
+
+		json_t *historyJ = json_object_get(rootJ, "history");
+		if (historyJ) history = clamp((int)json_integer_value(historyJ), 0, HISTORY_LEVELS - 1);
+
 	}
 
 	void onReset() override {
 		currCMap = 1;
 		path = "";
+		displayMode = DISPLAY_SCOPE;
+		triggerMode = TRIGGER_AUTO;
+		triggerChannel = 0;
+		triggerLevel = 0.0f;
+		triggerFalling = false;
+		holdoff = 0.0f;
+		preTrigger = 0.0f;
+		history = 0;
+		clearRing();
+		rearm();
+	}
+
+	void clearRing() {
+		std::fill(&ringMin[0][0][0], &ringMin[0][0][0] + HISTORY_LEVELS * 16 * RING_SIZE, 0.0f);
+		std::fill(&ringMax[0][0][0], &ringMax[0][0][0] + HISTORY_LEVELS * 16 * RING_SIZE, 0.0f);
+		std::fill(ringCaptured, ringCaptured + 16, 0);
+		ringPos = 0;
+		sweepStart = 0;
+	}
+
+	// Restart the sweep cycle, e.g. to take another single shot. Engine thread only, the UI sets rearmRequested
+	void rearm() {
+		sweepState = SWEEP_HOLDOFF;
+		stateTime = 0.0f;
+	}
+
+	// Write the current bucket to the ring, and merge it into the coarser levels. A coarser bucket is built up in
+	// place and is complete when the last bucket below it arrives
+	void closeBucket(int channels) {
+		unsigned int p = ringPos;
+		unsigned int k = p & (RING_SIZE - 1);
+		for (int c = 0; c < channels; c++) {
+			ringMin[0][c][k] = bucketMin[c / 4][c % 4];
+			ringMax[0][c][k] = bucketMax[c / 4][c % 4];
+			if (ringCaptured[c] < MAX_CAPTURED) {
+				ringCaptured[c]++;
+			}
+		}
+
+		for (int level = 1; level < HISTORY_LEVELS; level++) {
+			unsigned int part = p & (HISTORY_RATIO - 1);
+			unsigned int from = p & (RING_SIZE - 1);
+			p >>= HISTORY_SHIFT;
+			unsigned int to = p & (RING_SIZE - 1);
+			for (int c = 0; c < channels; c++) {
+				float lo = ringMin[level - 1][c][from];
+				float hi = ringMax[level - 1][c][from];
+				if (part == 0) {
+					ringMin[level][c][to] = lo;
+					ringMax[level][c][to] = hi;
+				} else {
+					ringMin[level][c][to] = std::min(ringMin[level][c][to], lo);
+					ringMax[level][c][to] = std::max(ringMax[level][c][to], hi);
+				}
+			}
+			if (part != HISTORY_RATIO - 1) {
+				break;
+			}
+		}
+
+		ringPos++;
+	}
+
+	// Copy the sweep captured so far from the ring into the frame being written, then publish it.
+	// Only the buckets the frame has not yet seen are copied. Above level 0 the frame ends with the sweep and
+	// reaches back over the history before it, as far as every channel has been captured
+	void publishFrame() {
+		int shift = HISTORY_SHIFT * sweepLevel;
+		unsigned int span = 1u << shift; // Level 0 buckets per frame bucket
+		unsigned int windowStart = ((sweepStart + BUFFER_SIZE) & ~(span - 1)) - BUFFER_SIZE * span;
+		int behind = (int)(ringPos - windowStart);
+		int length = std::min(behind >> shift, BUFFER_SIZE);
+		int start = 0;
+		for (int i = 0; i < ringChannels; i++) {
+			int missing = behind - ringCaptured[i];
+			if (missing > 0) {
+				start = std::max(start, (int)((missing + span - 1) >> shift));
+			}
+		}
+		start = std::min(start, length);
+
+		ScopeFrame &frame = frames.write();
+		int from = (frame.sweep == sweep && frame.channels == ringChannels) ? std::max(frame.length, start) : start;
+		unsigned int first = windowStart >> shift;
+		for (int i = 0; i < ringChannels; i++) {
+			for (int j = from; j < length; j++) {
+				unsigned int k = (first + j) & (RING_SIZE - 1);
+				frame.min[i][j] = ringMin[sweepLevel][i][k];
+				frame.max[i][j] = ringMax[sweepLevel][i][k];
+			}
+		}
+		frame.channels = ringChannels;
+		frame.start = start;
+		frame.length = length;
+		frame.sweep = sweep;
+		frame.generation = ++generation;
+		frames.publish();
+		publishCount = 0;
+	}
+
+	// Start a sweep at the current bucket, reaching back into the ring for the pre-trigger, but no further than
+	// every channel has been captured
+	void startSweep() {
+		int preLength = std::min((int)(preTrigger * BUFFER_SIZE), (int)std::min(ringPos, (unsigned int)RING_SIZE));
+		for (int c = 0; c < ringChannels; c++) {
+			preLength = std::min(preLength, ringCaptured[c]);
+		}
+		sweepStart = ringPos - preLength;
+		sweepLevel = history;
+		sweep++;
+		sweepState = SWEEP_CAPTURING;
+		publishCount = 0;
 	}
 
 	void process(const ProcessArgs &args) override {
 
+		if (rearmRequested.load(std::memory_order_relaxed) && rearmRequested.exchange(false, std::memory_order_acquire)) {
+			rearm();
+		}
+
 		// Compute time
 		float deltaTime = std::pow(2.0f, -params[TIME_PARAM].getValue());
 		int frameCount = static_cast<int>(std::ceil(deltaTime * args.sampleRate));
+		float bucketStep = (float)BUFFER_SIZE / (SWEEP_POINTS * (frameCount + 1)); // Buckets per sample
 
-		maxChannels = inputs[POLY_INPUT].getChannels();
-
-		// Add frame to buffer
-		if (bufferIndex < BUFFER_SIZE) {
-			if (++frameIndex > frameCount) {
-				for (int i = 0; i < 16; i++) {
-					buffer[i][bufferIndex] = inputs[POLY_INPUT].getVoltage(i);
-				}
-				bufferIndex++;
-				frameIndex = 0;
+		int channels = inputs[POLY_INPUT].getChannels();
+		if (channels != ringChannels) {
+			// Old buckets are meaningless for the new channels, so restart the sweep
+			for (int c = std::min(channels, ringChannels); c < 16; c++) {
+				ringCaptured[c] = 0;
+			}
+			ringChannels = channels;
+			if (sweepState == SWEEP_CAPTURING) {
+				sweepState = SWEEP_ARMED;
 			}
 		}
 
-		// Are we waiting on the next trigger?
-		if (bufferIndex >= BUFFER_SIZE) {
-			// Reset the Schmitt trigger so we don't trigger immediately if the input is high
-			if (frameIndex == 0) {
-				resetTrigger.reset();
+		// Add sample to the current bucket
+		simd::float_4 v[4];
+		for (int c = 0; c < 16; c += 4) {
+			v[c / 4] = inputs[POLY_INPUT].getVoltageSimd<simd::float_4>(c);
+			if (bucketEmpty) {
+				bucketMin[c / 4] = v[c / 4];
+				bucketMax[c / 4] = v[c / 4];
+			} else {
+				bucketMin[c / 4] = simd::fmin(bucketMin[c / 4], v[c / 4]);
+				bucketMax[c / 4] = simd::fmax(bucketMax[c / 4], v[c / 4]);
 			}
-			frameIndex++;
-
-			// Must go below 0.1fV to trigger
-			float gate = inputs[POLY_INPUT].getVoltage(0);
-
-			// Reset if triggered
-			float holdTime = 0.1f;
-			float trigParam = 0.0f;
-			if (resetTrigger.process(rescale(gate, trigParam - 0.1f, trigParam, 0.f, 1.f)) || (frameIndex >= args.sampleRate * holdTime)) {
-				bufferIndex = 0; 
-				frameIndex = 0; 
-				return;
+		}
+
+		bucketEmpty = false;
+
+		// Close every bucket this sample completes; at fast settings one sample can span several.
+		// The next bucket starts from this sample
+		bucketPos += bucketStep;
+		while (bucketPos >= 1.0f) {
+			closeBucket(channels);
+			bucketPos -= 1.0f;
+			for (int c = 0; c < 4; c++) {
+				bucketMin[c] = v[c];
+				bucketMax[c] = v[c];
 			}
+		}
 
-			// Reset if we've waited too long
-			if (frameIndex >= args.sampleRate * holdTime) {
-				bufferIndex = 0; 
-				frameIndex = 0; 
-				return;
+		// Collect whole blocks of raw samples for the spectrum, only while it is shown
+		if (displayMode == DISPLAY_SPECTRUM) {
+			SpectrumFrame &spectrum = spectra.write();
+			for (int c = 0; c < channels; c++) {
+				spectrum.samples[c][spectrumPos] = v[c / 4][c % 4];
 			}
+			if (++spectrumPos >= FFT_SIZE) {
+				spectrum.channels = channels;
+				spectrum.sampleRate = args.sampleRate;
+				spectrum.generation = ++spectrumGeneration;
+				spectra.publish();
+				spectrumPos = 0;
+			}
+		}
+
+		// Track the trigger source on every sample so an edge is never missed, whatever the sweep is doing
+		float gate = v[triggerChannel / 4][triggerChannel % 4];
+		if (triggerFalling) {
+			gate = -gate;
+		}
+		float level = triggerFalling ? -triggerLevel : triggerLevel;
+		bool triggered = trigger.process(rescale(gate, level - TRIGGER_HYSTERESIS, level, 0.f, 1.f));
+
+		stateTime += args.sampleTime;
+
+		switch (sweepState) {
+			case SWEEP_HOLDOFF:
+				if (stateTime >= holdoff) {
+					sweepState = SWEEP_ARMED;
+					stateTime = 0.0f;
+				}
+				break;
+			case SWEEP_ARMED:
+				if (triggered || (triggerMode == TRIGGER_AUTO && stateTime >= AUTO_TIME)) {
+					startSweep();
+				}
+				break;
+			case SWEEP_CAPTURING:
+				// Publish completed sweeps, and slow sweeps as they progress
+				if (ringPos - sweepStart >= (unsigned int)BUFFER_SIZE) {
+					publishFrame();
+					sweepState = (triggerMode == TRIGGER_SINGLE) ? SWEEP_STOPPED : SWEEP_HOLDOFF;
+					stateTime = 0.0f;
+				} else if (++publishCount >= PUBLISH_SAMPLES) {
+					publishFrame();
+				}
+				break;
+			case SWEEP_STOPPED:
+				break;
 		}
 	}
 };
@@ -261,41 +544,390 @@ struct Patch : Widget {
 
 };
 
+/**
+ * Drawn into a framebuffer, which is only re-rendered when a new frame is published or a display setting changes
+ */
 struct PolyScopeDisplay : TransparentWidget {
+	static const int MAX_COLUMNS = 1024;
+	static const int FFT_BINS = FFT_SIZE / 2 + 1;
+	static constexpr float SPECTRUM_RATE = 30.0f; // Most analyses per second
+	static constexpr float SPECTRUM_SMOOTHING = 0.7f; // Weight of the previous average
+	static constexpr float PEAK_DECAY = 0.95f; // Per analysis, in power
+	static constexpr float MIN_FREQ = 20.0f;
+	static constexpr float MIN_DB = -96.0f;
+	static constexpr float DECAY_RATE = 30.0f; // Persistence decay steps per second
+
 	PolyScope *module;
-	int frame = 0;
-	std::shared_ptr<Font> font;
+	FramebufferWidget *fb = NULL;
 
 	float t = 0.0;
 	float d = 0.008;
 
-	PolyScopeDisplay() { }
+	// What the framebuffer currently shows
+	unsigned int drawnGeneration = 0;
+	float drawnGain = 0.0f;
+	float drawnShift = 0.0f;
+	float drawnOffset = 0.0f;
+	int drawnCMap = -1;
+	int drawnMode = -1;
+
+	// Spectrum state, averaged over successive analyses
+	dsp::RealFFT fft;
+	alignas(16) float fftIn[FFT_SIZE];
+	alignas(16) float fftOut[FFT_SIZE];
+	float window[FFT_SIZE];
+	float windowSum = 0.0f;
+	float specAvg[16][FFT_BINS] = {};
+	float specPeak[16][FFT_BINS] = {};
+	int specChannels = 0;
+	float specRate = 0.0f;
+	unsigned int analysedGeneration = 0;
+	double lastAnalysis = 0.0;
+
+	// Persistence state: hits per plot pixel, drawn as one image
+	std::vector<uint16_t> hits;
+	std::vector<unsigned char> pixels;
+	int hitsWidth = 0;
+	int hitsHeight = 0;
+	unsigned int accumulatedSweep = 0;
+	int accumulatedColumns = 0;
+	bool lit = false;
+	double lastDecay = 0.0;
+	NVGcontext *imageVg = NULL;
+	int image = 0;
+	int imageWidth = 0;
+	int imageHeight = 0;
+
+	PolyScopeDisplay() : fft(FFT_SIZE) {
+		std::fill(window, window + FFT_SIZE, 1.0f);
+		dsp::hannWindow(window, FFT_SIZE);
+		for (int i = 0; i < FFT_SIZE; i++) {
+			windowSum += window[i];
+		}
+	}
+
+	~PolyScopeDisplay() {
+		if (image) {
+			nvgDeleteImage(imageVg, image);
+		}
+	}
+
+	Rect getPlotBox() {
+		return Rect(Vec(0, 15), box.size.minus(Vec(0, 15*2)));
+	}
+
+	// First pixel column whose buckets all hold signal
+	int getFirstColumn(const PolyScope::ScopeFrame &frame, int nColumns) {
+		return (frame.start * (nColumns - 1) + BUFFER_SIZE - 2) / (BUFFER_SIZE - 1);
+	}
+
+	// Extremes of one channel over the buckets under a pixel column
+	void getColumn(const PolyScope::ScopeFrame &frame, int k, int i, int nColumns, float &lo, float &hi) {
+		int start = i * (BUFFER_SIZE - 1) / (nColumns - 1);
+		int end = std::min(frame.length, std::max(start + 1, (i + 1) * (BUFFER_SIZE - 1) / (nColumns - 1)));
+		lo = frame.min[k][start];
+		hi = frame.max[k][start];
+		for (int j = start + 1; j < end; j++) {
+			lo = std::min(lo, frame.min[k][j]);
+			hi = std::max(hi, frame.max[k][j]);
+		}
+	}
+
+	float getGain() {
+		return std::pow(2.0f, module->params[PolyScope::SCALE_PARAM].getValue());
+	}
+
+	float getShift() {
+		return module->params[PolyScope::SHIFT_PARAM].getValue();
+	}
+
+	float getOffset() {
+		return module->toggle ? math::clamp(t, 0.0, 1.0) : module->params[PolyScope::SPREAD_PARAM].getValue();
+	}
+
+	void step() override {
+		TransparentWidget::step();
+
+		if (!module)
+			return;
+
+		if(module->toggle) {
+			t = t + d;
+			if ((t >= 1.0) || (t <= 0.0)) {
+				d = -d;
+			}
+		}
+
+		bool dirty = module->currCMap != drawnCMap || module->displayMode != drawnMode;
+
+		if (module->displayMode == PolyScope::DISPLAY_PERSISTENCE) {
+			const PolyScope::ScopeFrame &frame = module->frames.read();
+			if (frame.generation != drawnGeneration) {
+				accumulate(frame);
+				drawnGeneration = frame.generation;
+				dirty = true;
+			}
+			double now = system::getTime();
+			if (lit && now - lastDecay >= 1.0 / DECAY_RATE) {
+				decay();
+				lastDecay = now;
+				dirty = true;
+			}
+		} else if (module->displayMode == PolyScope::DISPLAY_SPECTRUM) {
+			const PolyScope::SpectrumFrame &spectrum = module->spectra.read();
+			double now = system::getTime();
+			if (spectrum.generation != analysedGeneration && now - lastAnalysis >= 1.0 / SPECTRUM_RATE) {
+				analyse(spectrum);
+				analysedGeneration = spectrum.generation;
+				lastAnalysis = now;
+				dirty = true;
+			}
+		} else {
+			const PolyScope::ScopeFrame &frame = module->frames.read();
+			dirty = dirty || 
+				frame.generation != drawnGeneration || 
+				getGain() != drawnGain || 
+				getShift() != drawnShift || 
+				getOffset() != drawnOffset;
+		}
+
+		if (dirty) {
+			fb->setDirty();
+		}
+	}
+
+	// Window and transform each channel, then fold the power into the running average and peak-hold
+	void analyse(const PolyScope::SpectrumFrame &spectrum) {
+		for (int k = specChannels; k < spectrum.channels; k++) {
+			std::fill(specAvg[k], specAvg[k] + FFT_BINS, 0.0f);
+			std::fill(specPeak[k], specPeak[k] + FFT_BINS, 0.0f);
+		}
+		specChannels = spectrum.channels;
+		specRate = spectrum.sampleRate;
+
+		float norm = 2.0f / (windowSum * 5.0f); // A 5V sine reads 0dB
+		for (int k = 0; k < spectrum.channels; k++) {
+			for (int i = 0; i < FFT_SIZE; i++) {
+				fftIn[i] = spectrum.samples[k][i] * window[i];
+			}
+			fft.rfft(fftIn, fftOut);
+
+			// Ordered output: DC and Nyquist come first, then interleaved pairs
+			for (int i = 0; i < FFT_BINS; i++) {
+				float re, im;
+				if (i == 0) {
+					re = fftOut[0];
+					im = 0.0f;
+				} else if (i == FFT_BINS - 1) {
+					re = fftOut[1];
+					im = 0.0f;
+				} else {
+					re = fftOut[2 * i];
+					im = fftOut[2 * i + 1];
+				}
+				float power = (re * re + im * im) * norm * norm;
+				specAvg[k][i] = specAvg[k][i] * SPECTRUM_SMOOTHING + power * (1.0f - SPECTRUM_SMOOTHING);
+				specPeak[k][i] = std::max(specPeak[k][i] * PEAK_DECAY, specAvg[k][i]);
+			}
+		}
+	}
+
+	// Add the columns a sweep has completed since the last call, one hit per pixel each trace covers
+	void accumulate(const PolyScope::ScopeFrame &frame) {
+		Rect b = getPlotBox();
+		int width = clamp((int)b.size.x, 2, MAX_COLUMNS);
+		int height = std::max((int)b.size.y, 1);
+		if (width != hitsWidth || height != hitsHeight) {
+			hitsWidth = width;
+			hitsHeight = height;
+			hits.assign(width * height, 0);
+			pixels.assign(width * height * 4, 0);
+		}
+
+		if (frame.sweep != accumulatedSweep) {
+			accumulatedSweep = frame.sweep;
+			accumulatedColumns = 0;
+		}
+
+		// Only whole columns, so a sweep published in pieces is not counted twice
+		int nComplete = (frame.length >= BUFFER_SIZE) ? width : frame.length * (width - 1) / (BUFFER_SIZE - 1);
+		int firstColumn = std::max(accumulatedColumns, getFirstColumn(frame, width));
+
+		float gain = getGain();
+		float shift = getShift();
+		float offset = getOffset();
+
+		for (int k = 0; k < frame.channels; k++) {
+			float colOffset = (k - 8) * offset + shift;
+			for (int i = firstColumn; i < nComplete; i++) {
+				float lo, hi;
+				getColumn(frame, k, i, width, lo, hi);
+				int top = (int)((1.0f - ((hi + colOffset) * gain / 10.0f / 2.0f + 0.5f)) * height);
+				int bottom = (int)((1.0f - ((lo + colOffset) * gain / 10.0f / 2.0f + 0.5f)) * height);
+				if (bottom < 0 || top >= height)
+					continue;
+				top = std::max(top, 0);
+				bottom = std::min(bottom, height - 1);
+				for (int y = top; y <= bottom; y++) {
+					uint16_t &h = hits[y * width + i];
+					if (h < UINT16_MAX)
+						h++;
+				}
+				lit = true;
+			}
+		}
+		accumulatedColumns = std::max(accumulatedColumns, nComplete);
+	}
 
-	void drawWaveform(const DrawArgs &args, float *valuesX) {
-		if (!valuesX)
+	// Fade every pixel by a sixteenth, always by at least one hit so it reaches zero
+	void decay() {
+		lit = false;
+		for (uint16_t &h : hits) {
+			if (h) {
+				h -= std::max(h >> 4, 1);
+				lit = lit || h;
+			}
+		}
+	}
+
+	// Colour the histogram through the current map, dimmest hits at the start of the map, on a log scale
+	void drawPersistence(const DrawArgs &args) {
+		if (hits.empty())
 			return;
+
+		uint16_t maxHits = *std::max_element(hits.begin(), hits.end());
+		float scale = maxHits ? 1.0f / std::log1p((float)maxHits) : 0.0f;
+		const colourMap &cMap = cMaps[module->currCMap];
+		for (size_t p = 0; p < hits.size(); p++) {
+			unsigned char *px = &pixels[p * 4];
+			if (!hits[p]) {
+				px[3] = 0;
+				continue;
+			}
+			float level = std::log1p((float)hits[p]) * scale;
+			const NVGcolor &c = cMap[std::min((int)(level * 16.0f), 15)];
+			px[0] = (unsigned char)(c.r * 255.0f);
+			px[1] = (unsigned char)(c.g * 255.0f);
+			px[2] = (unsigned char)(c.b * 255.0f);
+			px[3] = (unsigned char)(level * 255.0f);
+		}
+
+		// The image belongs to the context it was made in. A new context means the old one has gone, taking the
+		// image with it; otherwise the image is replaced when the histogram changes size
+		if (image && imageVg != args.vg) {
+			image = 0;
+		}
+		if (image && (imageWidth != hitsWidth || imageHeight != hitsHeight)) {
+			nvgDeleteImage(imageVg, image);
+			image = 0;
+		}
+		if (!image) {
+			image = nvgCreateImageRGBA(args.vg, hitsWidth, hitsHeight, 0, pixels.data());
+			imageVg = args.vg;
+			imageWidth = hitsWidth;
+			imageHeight = hitsHeight;
+		} else {
+			nvgUpdateImage(args.vg, image, pixels.data());
+		}
+
+		Rect b = getPlotBox();
+		NVGpaint paint = nvgImagePattern(args.vg, b.pos.x, b.pos.y, b.size.x, b.size.y, 0.0f, image, 1.0f);
+		nvgBeginPath(args.vg);
+		nvgRect(args.vg, b.pos.x, b.pos.y, b.size.x, b.size.y);
+		nvgFillPaint(args.vg, paint);
+		nvgFill(args.vg);
+	}
+
+	void drawTrace(const DrawArgs &args, Rect b, const float *values, int nColumns) {
+		nvgBeginPath(args.vg);
+		for (int i = 0; i < nColumns; i++) {
+			float x = b.pos.x + b.size.x * (float)i / (nColumns - 1);
+			float y = b.pos.y + b.size.y * (1.0f - values[i]);
+			if (i == 0)
+				nvgMoveTo(args.vg, x, y);
+			else
+				nvgLineTo(args.vg, x, y);
+		}
+		nvgStroke(args.vg);
+	}
+
+	// Log-frequency plot from MIN_FREQ to Nyquist, MIN_DB to 0dB, taking the loudest bin under each column
+	void drawSpectrum(const DrawArgs &args) {
+		if (specRate <= 0.0f)
+			return;
+
+		Rect b = getPlotBox();
+		int nColumns = clamp((int)box.size.x, 2, MAX_COLUMNS);
+		float binHz = specRate / FFT_SIZE;
+		float ratio = (specRate / 2.0f) / MIN_FREQ;
+
+		int binStart[MAX_COLUMNS + 1];
+		for (int i = 0; i <= nColumns; i++) {
+			float f = MIN_FREQ * std::pow(ratio, (float)i / nColumns);
+			binStart[i] = clamp((int)(f / binHz), 1, FFT_BINS - 1);
+		}
+
+		float avgLevel[MAX_COLUMNS];
+		float peakLevel[MAX_COLUMNS];
+
 		nvgSave(args.vg);
-		Rect b = Rect(Vec(0, 15), box.size.minus(Vec(0, 15*2)));
+		nvgScissor(args.vg, b.pos.x, b.pos.y, b.size.x, b.size.y);
+		nvgLineCap(args.vg, NVG_ROUND);
+		nvgLineJoin(args.vg, NVG_ROUND);
+		nvgGlobalCompositeOperation(args.vg, NVG_LIGHTER);
+
+		for (int k = 0; k < specChannels; k++) {
+			for (int i = 0; i < nColumns; i++) {
+				int end = std::max(binStart[i] + 1, binStart[i + 1]);
+				float avg = 0.0f;
+				float peak = 0.0f;
+				for (int j = binStart[i]; j < end && j < FFT_BINS; j++) {
+					avg = std::max(avg, specAvg[k][j]);
+					peak = std::max(peak, specPeak[k][j]);
+				}
+				avgLevel[i] = clamp(1.0f - 10.0f * std::log10(avg + 1e-12f) / MIN_DB, 0.0f, 1.0f);
+				peakLevel[i] = clamp(1.0f - 10.0f * std::log10(peak + 1e-12f) / MIN_DB, 0.0f, 1.0f);
+			}
+
+			nvgStrokeColor(args.vg, nvgTransRGBA(cMaps[module->currCMap][k], 96));
+			nvgStrokeWidth(args.vg, 0.75f);
+			drawTrace(args, b, peakLevel, nColumns);
+
+			nvgStrokeColor(args.vg, cMaps[module->currCMap][k]);
+			nvgStrokeWidth(args.vg, 1.25f);
+			drawTrace(args, b, avgLevel, nColumns);
+		}
+
+		nvgResetScissor(args.vg);
+		nvgRestore(args.vg);
+	}
+
+	// Draw the envelope of one channel from per-column extremes, already scaled to -1 to 1
+	void drawWaveform(const DrawArgs &args, const float *colMin, const float *colMax, int firstColumn, int nDrawn, int nColumns) {
+		nvgSave(args.vg);
+		Rect b = getPlotBox();
 		nvgScissor(args.vg, b.pos.x, b.pos.y, b.size.x, b.size.y);
 		nvgBeginPath(args.vg);
-		// Draw maximum display left to right
-		for (int i = 0; i < BUFFER_SIZE; i++) {
-			float x, y;
-			x = (float)i / (BUFFER_SIZE - 1);
-			y = valuesX[i] / 2.0f + 0.5f;
-
-			Vec p;
-			p.x = b.pos.x + b.size.x * x;
-			p.y = b.pos.y + b.size.y * (1.0f - y);
-			if (i == 0)
-				nvgMoveTo(args.vg, p.x, p.y);
+		// Upper edge left to right, then lower edge back, so a flat signal collapses to a line
+		for (int i = firstColumn; i < nDrawn; i++) {
+			float x = b.pos.x + b.size.x * (float)i / (nColumns - 1);
+			float y = b.pos.y + b.size.y * (1.0f - (colMax[i] / 2.0f + 0.5f));
+			if (i == firstColumn)
+				nvgMoveTo(args.vg, x, y);
 			else
-				nvgLineTo(args.vg, p.x, p.y);
+				nvgLineTo(args.vg, x, y);
 		}
+		for (int i = nDrawn - 1; i >= firstColumn; i--) {
+			float x = b.pos.x + b.size.x * (float)i / (nColumns - 1);
+			float y = b.pos.y + b.size.y * (1.0f - (colMin[i] / 2.0f + 0.5f));
+			nvgLineTo(args.vg, x, y);
+		}
+		nvgClosePath(args.vg);
 		nvgLineCap(args.vg, NVG_ROUND);
-		nvgMiterLimit(args.vg, 2.0f);
+		nvgLineJoin(args.vg, NVG_ROUND);
 		nvgStrokeWidth(args.vg, 1.25f);
 		nvgGlobalCompositeOperation(args.vg, NVG_LIGHTER);
+		nvgFill(args.vg);
 		nvgStroke(args.vg);
 		nvgResetScissor(args.vg);
 		nvgRestore(args.vg);
@@ -306,27 +938,56 @@ struct PolyScopeDisplay : TransparentWidget {
 		if (!module)
 			return;
 
-		if(module->toggle) {
-			t = t + d;
-			if ((t >= 1.0) || (t <= 0.0)) {
-				d = -d;
-			}
+		float gain = getGain();
+		float shift = getShift();
+		float offset = getOffset();
+
+		drawnCMap = module->currCMap;
+		drawnMode = module->displayMode;
+
+		if (module->displayMode == PolyScope::DISPLAY_SPECTRUM) {
+			drawSpectrum(args);
+			return;
+		}
+
+		if (module->displayMode == PolyScope::DISPLAY_PERSISTENCE) {
+			drawPersistence(args);
+			return;
 		}
 
-		float gain = std::pow(2.0f, module->params[PolyScope::SCALE_PARAM].getValue());
-		float shift = module->params[PolyScope::SHIFT_PARAM].getValue();
-		float offset = module->toggle ? math::clamp(t, 0.0, 1.0) : module->params[PolyScope::SPREAD_PARAM].getValue();
+		const PolyScope::ScopeFrame &frame = module->frames.read();
+
+		drawnGeneration = frame.generation;
+		drawnGain = gain;
+		drawnShift = shift;
+		drawnOffset = offset;
+
+		if (frame.length < 2)
+			return;
+
+		// One min/max pair per pixel column, however many buckets there are
+		int nColumns = clamp((int)box.size.x, 2, MAX_COLUMNS);
+		float colMin[MAX_COLUMNS];
+		float colMax[MAX_COLUMNS];
+
+		// Columns covered so far by a sweep in progress
+		int nDrawn = std::min(nColumns, (frame.length - 1) * (nColumns - 1) / (BUFFER_SIZE - 1) + 1);
+		int firstColumn = getFirstColumn(frame, nColumns);
+		if (nDrawn - firstColumn < 2)
+			return;
 
-		float values[16][BUFFER_SIZE];
-		for (int i = 0; i < BUFFER_SIZE; i++) {
-			for (int k = 0; k < 16; k++) {
-				values[k][i] = ((module->buffer[k][i] + ((k - 8) * offset)) + shift) * gain / 10.0f;
+		for (int k = 0; k < frame.channels; k++) {
+			float colOffset = (k - 8) * offset + shift;
+			for (int i = firstColumn; i < nDrawn; i++) {
+				float lo, hi;
+				getColumn(frame, k, i, nColumns, lo, hi);
+				colMin[i] = (lo + colOffset) * gain / 10.0f;
+				colMax[i] = (hi + colOffset) * gain / 10.0f;
 			}
-		}
 
-		for (int i = 0; i < module->maxChannels; i++) {
-			nvgStrokeColor(args.vg, cMaps[module->currCMap][i]);
-			drawWaveform(args, values[i]);
+			nvgStrokeColor(args.vg, cMaps[module->currCMap][k]);
+			nvgFillColor(args.vg, nvgTransRGBA(cMaps[module->currCMap][k], 96));
+			drawWaveform(args, colMin, colMax, firstColumn, nDrawn, nColumns);
 		}
 
 	}
@@ -362,9 +1023,55 @@ static void loadCMap(PolyScope *module) {
 #endif
 }
 
+template <typename T>
+struct ScopeOptionItem : MenuItem {
+	PolyScope *module;
+	T *setting;
+	T value;
+	void onAction(const event::Action &e) override {
+		*setting = value;
+		module->rearmRequested.store(true, std::memory_order_release);
+	}
+};
+
+template <typename T>
+struct ScopeOptionMenu : MenuItem {
+	PolyScope *module;
+	T *setting;
+	const std::vector<MenuOption<T>> *options;
+	Menu *createChildMenu() override {
+		Menu *menu = new Menu;
+		for (auto opt: *options) {
+			ScopeOptionItem<T> *item = createMenuItem<ScopeOptionItem<T>>(opt.name, CHECKMARK(*setting == opt.value));
+			item->module = module;
+			item->setting = setting;
+			item->value = opt.value;
+			menu->addChild(item);
+		}
+		return menu;
+	}
+};
+
+template <typename T>
+static void addScopeOptionMenu(Menu *menu, std::string name, PolyScope *module, T *setting, const std::vector<MenuOption<T>> &options) {
+	ScopeOptionMenu<T> *item = createMenuItem<ScopeOptionMenu<T>>(name);
+	item->module = module;
+	item->setting = setting;
+	item->options = &options;
+	menu->addChild(item);
+}
+
 struct PolyScopeWidget : ModuleWidget {
 
 	std::vector<MenuOption<int>> cmapOptions;
+	std::vector<MenuOption<int>> displayOptions;
+	std::vector<MenuOption<int>> modeOptions;
+	std::vector<MenuOption<int>> channelOptions;
+	std::vector<MenuOption<float>> levelOptions;
+	std::vector<MenuOption<bool>> slopeOptions;
+	std::vector<MenuOption<float>> holdoffOptions;
+	std::vector<MenuOption<float>> preTriggerOptions;
+	std::vector<MenuOption<int>> historyOptions;
 
 	PolyScopeWidget(PolyScope *module) {
 
@@ -372,11 +1079,17 @@ struct PolyScopeWidget : ModuleWidget {
 		setPanel(APP->window->loadSvg(asset::plugin(pluginInstance, "res/PolyScope.svg")));
 
 		{
+			FramebufferWidget *fb = new FramebufferWidget();
+			fb->box.pos = Vec(0, 20);
+			fb->box.size = Vec(345, 310);
+
 			PolyScopeDisplay *display = new PolyScopeDisplay();
 			display->module = module;
-			display->box.pos = Vec(0, 20);
-			display->box.size = Vec(345, 310);
-			addChild(display);
+			display->fb = fb;
+			display->box.size = fb->box.size;
+			fb->addChild(display);
+
+			addChild(fb);
 		}
 
 		{
@@ -401,6 +1114,44 @@ struct PolyScopeWidget : ModuleWidget {
 		cmapOptions.emplace_back("Synthwave", 4);
 		cmapOptions.emplace_back("User", 5);
 
+		displayOptions.emplace_back("Scope", PolyScope::DISPLAY_SCOPE);
+		displayOptions.emplace_back("Spectrum", PolyScope::DISPLAY_SPECTRUM);
+		displayOptions.emplace_back("Persistence", PolyScope::DISPLAY_PERSISTENCE);
+
+		modeOptions.emplace_back("Auto", PolyScope::TRIGGER_AUTO);
+		modeOptions.emplace_back("Normal", PolyScope::TRIGGER_NORMAL);
+		modeOptions.emplace_back("Single shot", PolyScope::TRIGGER_SINGLE);
+
+		for (int i = 0; i < 16; i++) {
+			channelOptions.emplace_back(string::f("Channel %d", i + 1), i);
+		}
+
+		levelOptions.emplace_back("-5V", -5.0f);
+		levelOptions.emplace_back("-2.5V", -2.5f);
+		levelOptions.emplace_back("-1V", -1.0f);
+		levelOptions.emplace_back("0V", 0.0f);
+		levelOptions.emplace_back("1V", 1.0f);
+		levelOptions.emplace_back("2.5V", 2.5f);
+		levelOptions.emplace_back("5V", 5.0f);
+
+		slopeOptions.emplace_back("Rising", false);
+		slopeOptions.emplace_back("Falling", true);
+
+		holdoffOptions.emplace_back("None", 0.0f);
+		holdoffOptions.emplace_back("10ms", 0.01f);
+		holdoffOptions.emplace_back("100ms", 0.1f);
+		holdoffOptions.emplace_back("1s", 1.0f);
+
+		preTriggerOptions.emplace_back("None", 0.0f);
+		preTriggerOptions.emplace_back("10%", 0.1f);
+		preTriggerOptions.emplace_back("25%", 0.25f);
+		preTriggerOptions.emplace_back("50%", 0.5f);
+
+		historyOptions.emplace_back("1 sweep", 0);
+		historyOptions.emplace_back("4 sweeps", 1);
+		historyOptions.emplace_back("16 sweeps", 2);
+		historyOptions.emplace_back("64 sweeps", 3);
+
 	}
 
 	void appendContextMenu(Menu *menu) override {
@@ -413,6 +1164,12 @@ struct PolyScopeWidget : ModuleWidget {
 			PolyScopeWidget *parent;
 		};
 
+		struct ArmItem : PolyScopeMenu {
+			void onAction(const event::Action &e) override {
+				module->rearmRequested.store(true, std::memory_order_release);
+			}
+		};
+
 		struct PathItem : PolyScopeMenu {
 			void onAction(const event::Action &e) override {
 				loadCMap(module);
@@ -449,6 +1206,24 @@ struct PolyScopeWidget : ModuleWidget {
 		pathItem->module = scope;
 		menu->addChild(pathItem);
 
+		addScopeOptionMenu(menu, "Display", scope, &scope->displayMode, displayOptions);
+		addScopeOptionMenu(menu, "History", scope, &scope->history, historyOptions);
+
+		menu->addChild(construct<MenuLabel>());
+		menu->addChild(construct<MenuLabel>(&MenuLabel::text, "Trigger"));
+
+		addScopeOptionMenu(menu, "Mode", scope, &scope->triggerMode, modeOptions);
+		addScopeOptionMenu(menu, "Source", scope, &scope->triggerChannel, channelOptions);
+		addScopeOptionMenu(menu, "Level", scope, &scope->triggerLevel, levelOptions);
+		addScopeOptionMenu(menu, "Slope", scope, &scope->triggerFalling, slopeOptions);
+		addScopeOptionMenu(menu, "Holdoff", scope, &scope->holdoff, holdoffOptions);
+		addScopeOptionMenu(menu, "Pre-trigger", scope, &scope->preTrigger, preTriggerOptions);
+
+		ArmItem *armItem = createMenuItem<ArmItem>("Arm single shot");
+		armItem->module = scope;
+		armItem->disabled = scope->triggerMode != PolyScope::TRIGGER_SINGLE;
+		menu->addChild(armItem);
+
 	 }
 
 };
@@ -76,22 +76,31 @@ struct Progress : core::AHModule {
 
 	void receiveEvent(core::ParamEvent e) override {
 		if (receiveEvents && e.pType != -1) { // AHParamWidgets that are no config through set<>() have a pType of -1
-			if (modeMode) {
-				paramState = "> " + 
-					music::noteNames[currRoot[e.pId]] + 
-					music::ChordTable[currChord[e.pId]].name + " " +  
-					music::inversionNames[currInv[e.pId]] + " " + "[" + 
-					music::DegreeString[currMode][currDegree[e.pId]] + "]";
-			} else {
-				paramState = "> " + 
-					music::noteNames[currRoot[e.pId]] + 
-					music::ChordTable[currChord[e.pId]].name + " " +  
-					music::inversionNames[currInv[e.pId]];
-			}
+			stateEvent = e;
 		}
 		keepStateDisplay = 0;
 	}
 
+	void getStateText(char *text, size_t size) override {
+		if (stateEvent.pType == -1) {
+			snprintf(text, size, ">");
+			return;
+		}
+		int i = stateEvent.pId;
+		if (modeMode) {
+			snprintf(text, size, "> %s%s %s [%s]", 
+				music::noteNames[currRoot[i]], 
+				music::ChordTable[currChord[i]].name, 
+				music::inversionNames[currInv[i]], 
+				music::DegreeString[currMode][currDegree[i]]);
+		} else {
+			snprintf(text, size, "> %s%s %s", 
+				music::noteNames[currRoot[i]], 
+				music::ChordTable[currChord[i]].name, 
+				music::inversionNames[currInv[i]]);
+		}
+	}
+
 	json_t *dataToJson() override {
 		json_t *rootJ = json_object();
 
@@ -376,7 +385,7 @@ void Progress::process(const ProcessArgs &args) {
 		// So, after all that, we calculate the pitch output
 		if (update) {
 
-			int *chordArray;
+			const int *chordArray;
 
 			// Get the array of pitches based on the inversion
 			switch(currInv[step]) {
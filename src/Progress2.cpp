@@ -53,6 +53,8 @@ struct Progress2 : core::AHModule {
 
 	Progress2() : core::AHModule(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS) { 
 
+		pState.rng = &rng;
+
 		configParam(CLOCK_PARAM, -2.0, 6.0, 2.0, "Clock tempo", " bpm", 2.f, 60.f);
 		configParam(RUN_PARAM, 0.0, 1.0, 0.0, "Run");
 		configParam(RESET_PARAM, 0.0, 1.0, 0.0, "Reset");
@@ -506,6 +508,8 @@ struct Progress2Widget : ModuleWidget {
 		scaleItem->parent = this;
 		menu->addChild(scaleItem);
 
+		menu->addChild(gui::createFixedSeedItem(progress));
+
 	}
 
 };
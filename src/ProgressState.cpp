@@ -15,18 +15,17 @@ void ProgressState::onReset() {
 }
 
 void ProgressState::calculateVoltages(int part, int step) {
-	int chordIndex = parts[part][step].chord;
-	int invIndex = parts[part][step].inversion;
-
-	music::ChordDefinition &chordDef = knownChords.chords[chordIndex];
-	std::vector<int> &invDef = chordDef.inversions[invIndex].formula;
-	parts[part][step].setVoltages(invDef, offset);
+	const music::InversionDefinition &invDef = music::knownChords.getChord(parts[part][step]);
+	parts[part][step].setVoltages(invDef, offset, *rng);
 }
 
 void ProgressState::update() {
 
+	bool changed = (nSteps != publishedSteps);
+
 	for (int step = 0; step < 8; step++) {
 		if (modeChanged || stateChanged || parts[currentPart][step].dirty) {
+			changed = true;
 			switch(chordMode) {
 				case ChordMode::NORMAL:
 					parts[currentPart][step].rootNote = parts[currentPart][step].note;
@@ -63,6 +62,24 @@ void ProgressState::update() {
 	}
 	stateChanged = false;
 	modeChanged = false;
+
+	if (changed) {
+		publish();
+	}
+}
+
+void ProgressState::publish() {
+	ProgressDisplay &d = display.write();
+	for (int step = 0; step < 8; step++) {
+		d.chords[step] = parts[currentPart][step];
+	}
+	d.chordMode = chordMode;
+	d.mode = mode;
+	d.key = key;
+	d.currentPart = currentPart;
+	d.nSteps = nSteps;
+	display.publish();
+	publishedSteps = nSteps;
 }
 
 void ProgressState::copyPartFrom(int src) {
@@ -300,9 +317,10 @@ void RootChoice::step() {
 		return;
 	}
 
-	ProgressChord *pC = pState->getChord(pState->currentPart, pStep);
+	const ProgressDisplay &d = pState->display.read();
+	const ProgressChord *pC = &d.chords[pStep];
 	
-	if(!pState->chordMode && pState->nSteps > pStep) {
+	if(!d.chordMode && d.nSteps > pStep) {
 		color = nvgRGBA(0x00, 0xFF, 0xFF, 0xFF);
 	} else {
 		color = nvgRGBA(0x00, 0xFF, 0xFF, 0x6F);
@@ -343,15 +361,16 @@ void DegreeChoice::step() {
 		return;
 	}
 
-	ProgressChord *pC = pState->getChord(pState->currentPart, pStep);
+	const ProgressDisplay &d = pState->display.read();
+	const ProgressChord *pC = &d.chords[pStep];
 
-	if(pState->chordMode && pState->nSteps > pStep) {
+	if(d.chordMode && d.nSteps > pStep) {
 		color = nvgRGBA(0x00, 0xFF, 0xFF, 0xFF);
 	} else {
 		color = nvgRGBA(0x00, 0xFF, 0xFF, 0x6F);
 	}
 
-	text = std::string("◊ ") + music::DegreeString[pState->mode][pC->modeDegree];
+	text = std::string("◊ ") + music::DegreeString[d.mode][pC->modeDegree];
 
 }
 // Degree
@@ -381,7 +400,7 @@ void ChordChoice::onAction(const rack::event::Action &e) {
 	if (!pState)
 		return;
 
-	size_t maxChords = music::BasicChordSet.size();
+	size_t maxChords = music::NUM_BASIC_CHORDS;
 
 	ui::Menu *menu = createMenu();
 	menu->addChild(createMenuLabel("Chord"));
@@ -409,10 +428,11 @@ void ChordChoice::step() {
 		return;
 	}
 
-	ProgressChord *pC = pState->getChord(pState->currentPart, pStep);
-	music::InversionDefinition &inv = pState->knownChords.chords[pC->chord].inversions[pC->inversion];
+	const ProgressDisplay &d = pState->display.read();
+	const ProgressChord *pC = &d.chords[pStep];
+	const music::InversionDefinition &inv = music::knownChords.getChord(*pC);
 
-	if(pState->nSteps > pStep) {
+	if(d.nSteps > pStep) {
 		color = nvgRGBA(0x00, 0xFF, 0xFF, 0xFF);
 	} else {
 		color = nvgRGBA(0x00, 0xFF, 0xFF, 0x6F);
@@ -420,8 +440,8 @@ void ChordChoice::step() {
 
 	text = std::to_string(pStep + 1) + std::string(": ◊ ");
 
-	if (pState->chordMode) {
-		text += inv.getName(pState->mode, pState->key, pC->modeDegree, pC->rootNote);
+	if (d.chordMode) {
+		text += inv.getName(d.mode, d.key, pC->modeDegree, pC->rootNote);
 	} else {
 		text += inv.getName(pC->rootNote);
 	}
@@ -459,14 +479,15 @@ void OctaveChoice::step() {
 		return;
 	}
 
-	if(pState->nSteps > pStep) {
+	const ProgressDisplay &d = pState->display.read();
+	const ProgressChord *pChord = &d.chords[pStep];
+
+	if(d.nSteps > pStep) {
 		color = nvgRGBA(0x00, 0xFF, 0xFF, 0xFF);
 	} else {
 		color = nvgRGBA(0x00, 0xFF, 0xFF, 0x6F);
 	}
 
-	ProgressChord *pChord = pState->getChord(pState->currentPart, pStep);
-
 	text = std::string("◊ ") + std::to_string(pChord->octave);
 
 }
@@ -501,14 +522,15 @@ void InversionChoice::step() {
 		return;
 	}
 
-	if(pState->nSteps > pStep) {
+	const ProgressDisplay &d = pState->display.read();
+	const ProgressChord *pChord = &d.chords[pStep];
+
+	if(d.nSteps > pStep) {
 		color = nvgRGBA(0x00, 0xFF, 0xFF, 0xFF);
 	} else {
 		color = nvgRGBA(0x00, 0xFF, 0xFF, 0x6F);
 	}
 
-	ProgressChord *pChord = pState->getChord(pState->currentPart, pStep);
-
 	text = std::string("◊ ") + music::inversionNames[pChord->inversion];
 
 }
@@ -520,13 +542,15 @@ void StatusBox::step() {
 		return;
 	}
 
-	if(pState->chordMode) {
+	const ProgressDisplay &d = pState->display.read();
+
+	if(d.chordMode) {
 		color = nvgRGBA(0x00, 0xFF, 0xFF, 0xFF);
 	} else {
 		color = nvgRGBA(0x00, 0xFF, 0xFF, 0x6F);
 	}
 
-	text = "Part " + std::to_string(pState->currentPart) + " " + music::NoteDegreeModeNames[pState->key][0][pState->mode] + " " + music::modeNames[pState->mode];
+	text = "Part " + std::to_string(d.currentPart) + " " + music::NoteDegreeModeNames[d.key][0][d.mode] + " " + music::modeNames[d.mode];
 
 }
 
@@ -25,16 +25,26 @@ struct ProgressChord : music::Chord {
 
 };
 
+// Consistent copy of the current part for the step widgets, published by ProgressState::update()
+struct ProgressDisplay {
+	ProgressChord chords[8];
+	ChordMode chordMode;
+	int mode;
+	int key;
+	int currentPart;
+	int nSteps;
+};
+
 struct ProgressState {
 
 	ChordMode chordMode = ChordMode::NORMAL;  // 0 == Chord, 1 = Mode, 2 = Coerce
 	int offset = 24; 	// Repeated notes in chord and expressed in the chord definition as being transposed 2 octaves lower. 
 						// When played this offset needs to be removed (or the notes removed, or the notes transposed to an octave higher)
 
-	music::KnownChords knownChords;
-
 	ProgressChord parts[32][8];
 
+	core::Random *rng = nullptr; // Owning module's generator, used for random offsets
+
 	ProgressState();
 	json_t *toJson();
 	void fromJson(json_t *pStateJ);
@@ -62,6 +72,10 @@ struct ProgressState {
 	bool stateChanged;
 	bool modeChanged;
 
+	core::SnapshotBuffer<ProgressDisplay> display;
+	int publishedSteps = -1;
+	void publish();
+
 };
 
 // Menu Items
@@ -187,7 +187,7 @@ void Ruckus::process(const ProcessArgs &args) {
 				}
 
 				if (target % division[i] == 0) { 
-					if (random::uniform() < prob[i]) {
+					if (rng.uniform() < prob[i]) {
 						xGate[x].trigger(digital::TRIGGER);
 						yGate[y].trigger(digital::TRIGGER);
 						state[i] = 2; // Triggered
@@ -373,6 +373,16 @@ struct RuckusWidget : ModuleWidget {
 		addChild(createLightCentered<SmallLight<GreenLight>>(Vec(290.804, 251.683), module, Ruckus::YMUTE_LIGHT + 3));
 
 	}
+
+	void appendContextMenu(Menu *menu) override {
+
+		Ruckus *ruckus = dynamic_cast<Ruckus*>(module);
+		assert(ruckus);
+
+		menu->addChild(construct<MenuLabel>());
+		menu->addChild(gui::createFixedSeedItem(ruckus));
+
+	}
 };
 
 Model *modelRuckus = createModel<Ruckus, RuckusWidget>("Ruckus");
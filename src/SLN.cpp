@@ -1,4 +1,4 @@
-#include "dsp/noise.hpp"
+#include "dsp/blocknoise.hpp"
 
 #include "AH.hpp"
 #include "AHCommon.hpp"
@@ -58,25 +58,28 @@ struct SLN : core::AHModule {
 		paramQuantities[NOISE_PARAM]->description = "White, pink (1/f) or brown (1/f^2) noise";
 
 		configParam(ATTN_PARAM, 0.0, 1.0, 1.0, "Level", "%", 0.0f, 100.0f);
+
+		reseed();
 	}
 
 	void process(const ProcessArgs &args) override;
 
-	rack::dsp::SchmittTrigger inTrigger;
-	bogaudio::dsp::WhiteNoiseGenerator white;
-	bogaudio::dsp::PinkNoiseGenerator pink;
-	bogaudio::dsp::RedNoiseGenerator brown;
-
-	float target = 0.0f;
-	float current = 0.0f;
-
-	// minimum and maximum slopes in volts per second
-	const float slewMin = 0.1;
-	const float slewMax = 10000.0;	
-	const float slewRatio = slewMin / slewMax;
+	// Channels run four to a simd::float_4, one entry per group of four
+	rack::dsp::TSchmittTrigger<simd::float_4> inTrigger[4];
+	noise::WhiteNoise4 white[4];
+	noise::PinkNoise4 pink[4];
+	noise::BrownNoise4 brown[4];
+
+	void onReseed() override {
+		for (int g = 0; g < 4; g++) {
+			white[g].seed(rng.next());
+			pink[g].seed(rng.next());
+			brown[g].seed(rng.next());
+		}
+	}
 
-	// Amount of extra slew per voltage difference
-	const float shapeScale = 1.0/10.0;
+	simd::float_4 target[4] = {};
+	digital::SlewLimiter<simd::float_4> slew[4];
 
 };
 
@@ -84,49 +87,41 @@ void SLN::process(const ProcessArgs &args) {
 
 	AHModule::step();
 
-	float noise;
+	int channels = std::max(inputs[TRIG_INPUT].getChannels(), 1);
 	int noiseType = params[NOISE_PARAM].getValue();
 	float attn = params[ATTN_PARAM].getValue();
 
-	switch(noiseType) {
-		case 0:
-			noise = clamp(white.next() * 10.0f, -10.0f, 10.f);
-			break;
-		case 1:
-			noise = clamp(pink.next() * 15.0f, -10.0f, 10.f);
-			break;
-		case 2:
-			noise = clamp(brown.next() * 35.0f, -10.0f, 10.f);
-			break;
-		default:
-			noise = clamp(white.next() * 10.0f, -10.0f, 10.f);
-	}
-
-	// Capture noise
-	if (inTrigger.process(inputs[TRIG_INPUT].getVoltage() / 0.7)) {
-		target = noise;
-	} 
-
 	float shape = params[SLOPE_PARAM].getValue();
 	float speed = params[SPEED_PARAM].getValue();
 
-	float slew = slewMax * powf(slewRatio, speed);
-
-	// Rise
-	if (target > current) {
-		current += slew * crossfade(1.0f, shapeScale * (target - current), shape) * args.sampleTime;
-		if (current > target) // Trap overshoot
-			current = target;
-	}
-	// Fall
-	else if (target < current) {
-		current -= slew * crossfade(1.0f, shapeScale * (current - target), shape) * args.sampleTime;
-		if (current < target) // Trap overshoot
-			current = target;
+	for (int c = 0; c < channels; c += 4) {
+		int g = c / 4;
+
+		simd::float_4 noise;
+		switch(noiseType) {
+			case 1:
+				noise = simd::clamp(pink[g].next() * 15.0f, -10.0f, 10.f);
+				break;
+			case 2:
+				noise = simd::clamp(brown[g].next() * 15.0f, -10.0f, 10.f);
+				break;
+			default:
+				noise = simd::clamp(white[g].next() * 10.0f, -10.0f, 10.f);
+		}
+
+		// Capture noise
+		simd::float_4 triggered = inTrigger[g].process(inputs[TRIG_INPUT].getVoltageSimd<simd::float_4>(c) / 0.7f);
+		target[g] = simd::ifelse(triggered, noise, target[g]);
+
+		slew[g].setParams(speed, shape, args.sampleTime);
+		simd::float_4 current = slew[g].process(target[g]);
+
+		outputs[OUT_OUTPUT].setVoltageSimd(current * attn, c);
+		outputs[NOISE_OUTPUT].setVoltageSimd(noise, c);
 	}
 
-	outputs[OUT_OUTPUT].setVoltage(current * attn);
-	outputs[NOISE_OUTPUT].setVoltage(noise);
+	outputs[OUT_OUTPUT].setChannels(channels);
+	outputs[NOISE_OUTPUT].setChannels(channels);
 
 }
 
@@ -149,6 +144,16 @@ struct SLNWidget : ModuleWidget {
 
 	}
 
+	void appendContextMenu(Menu *menu) override {
+
+		SLN *sln = dynamic_cast<SLN*>(module);
+		assert(sln);
+
+		menu->addChild(construct<MenuLabel>());
+		menu->addChild(gui::createFixedSeedItem(sln));
+
+	}
+
 };
 
 Model *modelSLN = createModel<SLN, SLNWidget>("SLN");
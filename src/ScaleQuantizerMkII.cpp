@@ -72,13 +72,12 @@ struct ScaleQuantizer2 : core::AHModule {
 	int lastRoot = 0;
 	float lastTrans = -10000.0f;
 
-	dsp::SchmittTrigger holdTrigger[8][16];
-	dsp::PulseGenerator triggerPulse[8][16];
+	// Channels are processed 4 at a time
+	dsp::TSchmittTrigger<simd::float_4> holdTrigger[8][4];
+	digital::AHPulseGenerator4 triggerPulse[8][4];
 
-	float holdPitch[8][16] = {};
-	float lastPitch[8][16] = {};
-
-	bool holdState[8][16];
+	simd::float_4 holdPitch[8][4] = {};
+	simd::float_4 lastPitch[8][4] = {};
 
 	int currScale = 0;
 	int currRoot = 0;
@@ -129,45 +128,43 @@ void ScaleQuantizer2::process(const ProcessArgs &args) {
 		outputs[OUT_OUTPUT + i].setChannels(nChannels);
 		outputs[TRIG_OUTPUT + i].setChannels(nChannels);
 
-		for (int j = 0; j < nChannels; j++) {
+		simd::float_4 holdChannel0 = simd::float_4::zero();
+
+		for (int j = 0; j < nChannels; j += 4) {
+
+			int c = j / 4;
 
-			holdState[i][j] = holdTrigger[i][j].process(inputs[HOLD_INPUT + i].getVoltage(j));
+			simd::float_4 holdState = holdTrigger[i][c].process(inputs[HOLD_INPUT + i].getVoltageSimd<simd::float_4>(j));
 
+			simd::float_4 sample;
 			if (nHoldChannels == 0) {
-				holdPitch[i][j] = music::getPitchFromVolts(inputs[IN_INPUT + i].getVoltage(j), currRoot, currScale);
+				sample = simd::float_4::mask();
 			} else if (nHoldChannels == 1) {
-				if (holdState[i][0]) { // Use channel 0 for hold
-					holdPitch[i][j] = music::getPitchFromVolts(inputs[IN_INPUT + i].getVoltage(j), currRoot, currScale);
+				if (c == 0) { // Use channel 0 for hold
+					holdChannel0 = (simd::movemask(holdState) & 1) ? simd::float_4::mask() : simd::float_4::zero();
 				}
+				sample = holdChannel0;
 			} else {
-				if (nCVChannels == 1) {
-					if (holdState[i][j]) {
-						holdPitch[i][j] = music::getPitchFromVolts(inputs[IN_INPUT + i].getVoltage(0), currRoot, currScale); // (re)-sample channel 0
-					}
+				sample = holdState;
+			}
+
+			if (simd::movemask(sample)) {
+				simd::float_4 cv;
+				if (nHoldChannels > 1 && nCVChannels == 1) {
+					cv = inputs[IN_INPUT + i].getVoltage(0); // (re)-sample channel 0
 				} else {
-					if (holdState[i][j]) {
-						holdPitch[i][j] = music::getPitchFromVolts(inputs[IN_INPUT + i].getVoltage(j), currRoot, currScale);
-					}
+					cv = inputs[IN_INPUT + i].getVoltageSimd<simd::float_4>(j);
 				}
+				holdPitch[i][c] = simd::ifelse(sample, music::getPitchFromVolts(cv, currRoot, currScale), holdPitch[i][c]);
 			}
 
-			// If the quantised pitch has changed
-			if (lastPitch[i][j] != holdPitch[i][j]) {
+			// If the quantised pitch has changed, record the pitch and pulse the gate
+			simd::float_4 changed = lastPitch[i][c] != holdPitch[i][c];
+			lastPitch[i][c] = holdPitch[i][c];
+			triggerPulse[i][c].trigger(changed, digital::TRIGGER);
 
-				// Record the pitch
-				lastPitch[i][j] = holdPitch[i][j];
-
-				// Pulse the gate
-				triggerPulse[i][j].trigger(digital::TRIGGER);
-			} 
-
-			outputs[OUT_OUTPUT + i].setVoltage(holdPitch[i][j] + shift + trans, j);
-
-			if (triggerPulse[i][j].process(args.sampleTime)) {
-				outputs[TRIG_OUTPUT + i].setVoltage(10.0f, j);
-			} else {
-				outputs[TRIG_OUTPUT + i].setVoltage(0.0f, j);
-			}
+			outputs[OUT_OUTPUT + i].setVoltageSimd(holdPitch[i][c] + shift + trans, j);
+			outputs[TRIG_OUTPUT + i].setVoltageSimd(simd::ifelse(triggerPulse[i][c].process(args.sampleTime), 10.0f, 0.0f), j);
 
 		}
 
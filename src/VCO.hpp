@@ -2,157 +2,350 @@
 
 using namespace ah;
 
-// Andrew Belt's LFO-2 code
+// Andrew Belt's LFO-2 code, for a float or the four lanes of a simd::float_4
+template <typename T>
 struct LowFrequencyOscillator {
-	float phase = 0.0f;
-	float pw = 0.5f;
-	float freq = 1.0f;
+	T phase = 0.0f;
+	T pw = 0.5f;
+	T freq = 1.0f;
 	bool offset = false;
 	bool invert = false;
-	rack::dsp::SchmittTrigger resetTrigger;
+	rack::dsp::TSchmittTrigger<T> resetTrigger;
 
 	LowFrequencyOscillator() {}
-	void setPitch(float pitch) {
-		pitch = fminf(pitch, 10.0f);
-		freq = powf(2.0f, pitch);
+	void setPitch(T pitch) {
+		pitch = simd::fmin(pitch, 10.0f);
+		// The approximation wants a positive argument
+		freq = rack::dsp::exp2_taylor5(pitch + 20.0f) / 1048576.0f;
 	}
-	void setPulseWidth(float pw_) {
+	void setPulseWidth(T pw_) {
 		const float pwMin = 0.01f;
-		pw = clamp(pw_, pwMin, 1.0f - pwMin);
+		pw = simd::clamp(pw_, pwMin, 1.0f - pwMin);
 	}
-	void setReset(float reset) {
-		if (resetTrigger.process(reset / 0.01f)) {
-			phase = 0.0f;
-		}
+	void setReset(T reset) {
+		phase = simd::ifelse(resetTrigger.process(reset / 0.01f), 0.0f, phase);
 	}
 	void step(float dt) {
-		float deltaPhase = fminf(freq * dt, 0.5f);
+		T deltaPhase = simd::fmin(freq * dt, 0.5f);
 		phase += deltaPhase;
-		if (phase >= 1.0f)
-			phase -= 1.0f;
+		phase = simd::ifelse(phase >= 1.0f, phase - 1.0f, phase);
 	}
-	float sin() {
+	T sin() {
 		if (offset)
-			return 1.0f - cosf(2 * core::PI * phase) * (invert ? -1.0f : 1.0f);
+			return 1.0f - simd::cos(2.0f * (float)core::PI * phase) * (invert ? -1.0f : 1.0f);
 		else
-			return sinf(2 * core::PI * phase) * (invert ? -1.0f : 1.0f);
+			return simd::sin(2.0f * (float)core::PI * phase) * (invert ? -1.0f : 1.0f);
 	}
-	float tri(float x) {
-		return 4.0f * fabsf(x - roundf(x));
+	T tri(T x) {
+		return 4.0f * simd::fabs(x - simd::round(x));
 	}
-	float tri() {
+	T tri() {
 		if (offset)
 			return tri(invert ? phase - 0.5f : phase);
 		else
 			return -1.0f + tri(invert ? phase - 0.25f : phase - 0.75f);
 	}
-	float saw(float x) {
-		return 2.0f * (x - roundf(x));
+	T saw(T x) {
+		return 2.0f * (x - simd::round(x));
 	}
-	float saw() {
+	T saw() {
 		if (offset)
 			return invert ? 2.0f * (1.0f - phase) : 2.0f * phase;
 		else
 			return saw(phase) * (invert ? -1.0f : 1.0f);
 	}
-	float sqr() {
-		float sqr = (phase < pw) ^ invert ? 1.0f : -1.0f;
+	T sqr() {
+		T sqr = simd::ifelse(invert ? phase >= pw : phase < pw, 1.0f, -1.0f);
 		return offset ? sqr + 1.0f : sqr;
 	}
-	float light() {
-		return sinf(2 * core::PI * phase);
+	T light() {
+		return simd::sin(2.0f * (float)core::PI * phase);
 	}
 };
 
-// A 'portable' version of Andrew Belt's EvenVCO code, which is much less CPU intensive than VCO-1 or -2
+// A 'portable' version of Andrew Belt's EvenVCO code, which is much less CPU intensive than VCO-1 or -2.
+// T is simd::float_4, one voice per lane. Only the waveforms set in waves are computed, along with their MinBLEPs
+template <typename T>
 struct EvenVCO {
 
-	float phase = 0.0;
-	/** The value of the last sync input */
-	float sync = 0.0;
-	/** The outputs */
-	float tri = 0.0;
-	/** Whether we are past the pulse width already */
-	bool halfPhase = false;
+	enum Waveform {
+		SINE = 1,
+		SAW = 2,
+		DOUBLESAW = 4,
+		SQUARE = 8,
+		EVEN = 16, // Needs the sine and double saw
+		TRI = 32,
+		ALL = 63
+	};
 
-	dsp::MinBlepGenerator<16, 32> triSquareMinBLEP;
-	dsp::MinBlepGenerator<16, 32> triMinBLEP;
-	dsp::MinBlepGenerator<16, 32> sineMinBLEP;
-	dsp::MinBlepGenerator<16, 32> doubleSawMinBLEP;
-	dsp::MinBlepGenerator<16, 32> sawMinBLEP;
-	dsp::MinBlepGenerator<16, 32> squareMinBLEP;
+	T phase = 0.0f;
+	T tri = 0.0f;
 
-	dsp::RCFilter triFilter;
+	int waves = ALL;
 
-    float pw;
+	dsp::MinBlepGenerator<16, 32, T> triSquareMinBLEP;
+	dsp::MinBlepGenerator<16, 32, T> doubleSawMinBLEP;
+	dsp::MinBlepGenerator<16, 32, T> sawMinBLEP;
+	dsp::MinBlepGenerator<16, 32, T> squareMinBLEP;
 
-   	float sine;
-	float doubleSaw;
-	float even;
-	float saw;
-	float square;
+	T pw = 0.0f;
+
+	/** The outputs */
+	T sine = 0.0f;
+	T doubleSaw = 0.0f;
+	T even = 0.0f;
+	T saw = 0.0f;
+	T square = 0.0f;
 
 	EvenVCO() {	}
 
 	void reset() {
-		phase = 0.0;
-		sync = 0.0;
-		tri = 0.0;
-		halfPhase = false;
+		phase = 0.0f;
+		tri = 0.0f;
 	}
 
-	void step(float delta, float pitch) {
-		// Compute frequency, pitch is 1V/oct
-		float freq = dsp::FREQ_C4 * powf(2.0, pitch);
-		freq = rack::clamp(freq, 0.0f, 20000.0f);
+	void step(float delta, T pitch) {
+		bool needTri = waves & TRI;
+		bool needSine = waves & (SINE | EVEN);
+		bool needDoubleSaw = waves & (DOUBLESAW | EVEN);
+		bool needSaw = waves & SAW;
+		bool needSquare = waves & SQUARE;
+
+		// Compute frequency, pitch is 1V/oct. The approximation wants a positive argument
+		T freq = dsp::FREQ_C4 * dsp::exp2_taylor5(pitch + 20.0f) / 1048576.0f;
+		freq = simd::clamp(freq, 0.0f, 20000.0f);
 
 		// Pulse width
-		const float minPw = 0.05;
-		pw = rack::rescale(rack::clamp(pw, -1.0f, 1.0f), -1.0f, 1.0f, minPw, 1.0f - minPw);
+		const float minPw = 0.05f;
+		T width = minPw + (simd::clamp(pw, -1.0f, 1.0f) + 1.0f) * (0.5f - minPw);
 
 		// Advance phase
-		float deltaPhase = rack::clamp(freq * delta, 1e-6f, 0.5f);
-		float oldPhase = phase;
+		T deltaPhase = simd::clamp(freq * delta, 1e-6f, 0.5f);
+		T oldPhase = phase;
 		phase += deltaPhase;
 
-		if (oldPhase < 0.5 && phase >= 0.5) {
-			float crossing = -(phase - 0.5) / deltaPhase;
-			triSquareMinBLEP.insertDiscontinuity(crossing, 2.0);
-			doubleSawMinBLEP.insertDiscontinuity(crossing, -2.0);
+		// Discontinuities are rare, so they are inserted lane by lane
+		if (needTri || needDoubleSaw) {
+			int half = simd::movemask((oldPhase < 0.5f) & (phase >= 0.5f));
+			for (int i = 0; half; i++, half >>= 1) {
+				if (half & 1) {
+					float crossing = -(phase[i] - 0.5f) / deltaPhase[i];
+					T lane = digital::laneMask(1 << i);
+					if (needTri)
+						triSquareMinBLEP.insertDiscontinuity(crossing, lane & T(2.0f));
+					if (needDoubleSaw)
+						doubleSawMinBLEP.insertDiscontinuity(crossing, lane & T(-2.0f));
+				}
+			}
 		}
 
-		if (!halfPhase && phase >= pw) {
-			float crossing  = -(phase - pw) / deltaPhase;
-			squareMinBLEP.insertDiscontinuity(crossing, 2.0);
-			halfPhase = true;
+		if (needSquare) {
+			int fall = simd::movemask((oldPhase < width) & (phase >= width));
+			for (int i = 0; fall; i++, fall >>= 1) {
+				if (fall & 1) {
+					float crossing = -(phase[i] - width[i]) / deltaPhase[i];
+					squareMinBLEP.insertDiscontinuity(crossing, digital::laneMask(1 << i) & T(2.0f));
+				}
+			}
 		}
 
 		// Reset phase if at end of cycle
-		if (phase >= 1.0) {
-			phase -= 1.0;
-			float crossing = -phase / deltaPhase;
-			triSquareMinBLEP.insertDiscontinuity(crossing, -2.0);
-			doubleSawMinBLEP.insertDiscontinuity(crossing, -2.0);
-			squareMinBLEP.insertDiscontinuity(crossing, -2.0);
-			sawMinBLEP.insertDiscontinuity(crossing, -2.0);
-			halfPhase = false;
+		T wrap = phase >= 1.0f;
+		phase = simd::ifelse(wrap, phase - 1.0f, phase);
+		int wrapped = simd::movemask(wrap);
+		for (int i = 0; wrapped; i++, wrapped >>= 1) {
+			if (wrapped & 1) {
+				float crossing = -phase[i] / deltaPhase[i];
+				T jump = digital::laneMask(1 << i) & T(-2.0f);
+				if (needTri)
+					triSquareMinBLEP.insertDiscontinuity(crossing, jump);
+				if (needDoubleSaw)
+					doubleSawMinBLEP.insertDiscontinuity(crossing, jump);
+				if (needSquare)
+					squareMinBLEP.insertDiscontinuity(crossing, jump);
+				if (needSaw)
+					sawMinBLEP.insertDiscontinuity(crossing, jump);
+			}
 		}
 
 		// Outputs
-		float triSquare = (phase < 0.5) ? -1.0 : 1.0;
-		triSquare += triSquareMinBLEP.process();
-
-		// Integrate square for triangle
-		tri += 4.0 * triSquare * freq * delta;
-		tri *= (1.0 - 40.0 * delta);
-
-		sine = -cosf(2* core::PI * phase);
-		doubleSaw = (phase < 0.5) ? (-1.0 + 4.0*phase) : (-1.0 + 4.0*(phase - 0.5));
-		doubleSaw += doubleSawMinBLEP.process();
-		even = 0.55 * (doubleSaw + 1.27 * sine);
-		saw = -1.0 + 2.0*phase;
-		saw += sawMinBLEP.process();
-		square = (phase < pw) ? -1.0 : 1.0;
-		square += squareMinBLEP.process();
-	}
-};
\ No newline at end of file
+		if (needTri) {
+			T triSquare = simd::ifelse(phase < 0.5f, -1.0f, 1.0f);
+			triSquare += triSquareMinBLEP.process();
+
+			// Integrate square for triangle
+			tri += 4.0f * triSquare * freq * delta;
+			tri *= (1.0f - 40.0f * delta);
+		}
+
+		if (needSine) {
+			sine = -simd::cos(2.0f * (float)core::PI * phase);
+		}
+
+		if (needDoubleSaw) {
+			doubleSaw = simd::ifelse(phase < 0.5f, -1.0f + 4.0f * phase, -1.0f + 4.0f * (phase - 0.5f));
+			doubleSaw += doubleSawMinBLEP.process();
+		}
+
+		if (waves & EVEN) {
+			even = 0.55f * (doubleSaw + 1.27f * sine);
+		}
+
+		if (needSaw) {
+			saw = -1.0f + 2.0f * phase;
+			saw += sawMinBLEP.process();
+		}
+
+		if (needSquare) {
+			square = simd::ifelse(phase < width, -1.0f, 1.0f);
+			square += squareMinBLEP.process();
+		}
+	}
+};
+
+/*
+* Band-limited tables shared by every WavetableVCO: a sine, and a rising saw at each octave of harmonic content.
+* They are built once by additive synthesis, the first time an oscillator is created.
+*/
+struct Wavetables {
+
+	static const int SIZE = 2048;
+	static const int LEVELS = 10; // Level k holds harmonics 1 to 2^k
+
+	// Point 0 is the last of the cycle and the final two wrap to the start, so cubic reads never need to wrap
+	float sine[SIZE + 3];
+	float saw[LEVELS][SIZE + 3];
+
+	static const Wavetables &get() {
+		static const Wavetables tables;
+		return tables;
+	}
+
+	Wavetables() {
+		std::vector<double> sinTable(SIZE);
+		for (int n = 0; n < SIZE; n++) {
+			sinTable[n] = std::sin(2.0 * core::PI * n / SIZE);
+		}
+
+		std::vector<double> acc(SIZE);
+		for (int n = 0; n < SIZE; n++) {
+			acc[n] = -sinTable[(n + SIZE / 4) % SIZE]; // -cos, as EvenVCO
+		}
+		fill(sine, acc);
+
+		// -1 + 2p = -(2 / pi) * sum(sin(2 pi k p) / k)
+		std::fill(acc.begin(), acc.end(), 0.0);
+		int harmonic = 1;
+		for (int level = 0; level < LEVELS; level++) {
+			for (; harmonic <= (1 << level); harmonic++) {
+				double a = -2.0 / (core::PI * harmonic);
+				for (int n = 0; n < SIZE; n++) {
+					acc[n] += a * sinTable[(harmonic * n) % SIZE];
+				}
+			}
+			fill(saw[level], acc);
+		}
+	}
+
+	static void fill(float *table, const std::vector<double> &cycle) {
+		table[0] = cycle[SIZE - 1];
+		for (int n = 0; n < SIZE; n++) {
+			table[n + 1] = cycle[n];
+		}
+		table[SIZE + 1] = cycle[0];
+		table[SIZE + 2] = cycle[1];
+	}
+
+	// The level with the most harmonics that all stay below Nyquist
+	static int level(float deltaPhase) {
+		return clamp(std::ilogb(0.5f / deltaPhase), 0, LEVELS - 1);
+	}
+
+	// Phase in [0, 1), linear or 4-point Catmull-Rom between table points
+	static float read(const float *table, float phase, bool cubic) {
+		float pos = phase * SIZE;
+		int i = std::min((int)pos, SIZE - 1);
+		float f = pos - i;
+		const float *p = table + i + 1;
+		if (!cubic)
+			return p[0] + (p[1] - p[0]) * f;
+		return p[0] + 0.5f * f * (p[1] - p[-1] + f * (2.0f * p[-1] - 5.0f * p[0] + 4.0f * p[1] - p[2] + f * (3.0f * (p[0] - p[1]) + p[2] - p[-1])));
+	}
+
+};
+
+// Table-reading counterpart to EvenVCO with the same outputs, at a cost that does not depend on pitch. The pulse is
+// the difference of two saws a pulse width apart. T is simd::float_4, one voice per lane
+template <typename T>
+struct WavetableVCO {
+
+	const Wavetables &tables = Wavetables::get();
+
+	T phase = 0.0f;
+
+	int waves = EvenVCO<T>::ALL;
+	bool cubic = true;
+
+	T pw = 0.0f;
+
+	/** The outputs */
+	T sine = 0.0f;
+	T doubleSaw = 0.0f;
+	T even = 0.0f;
+	T saw = 0.0f;
+	T square = 0.0f;
+
+	void reset() {
+		phase = 0.0f;
+	}
+
+	void step(float delta, T pitch) {
+		bool needSine = waves & (EvenVCO<T>::SINE | EvenVCO<T>::EVEN);
+		bool needDoubleSaw = waves & (EvenVCO<T>::DOUBLESAW | EvenVCO<T>::EVEN);
+		bool needSaw = waves & EvenVCO<T>::SAW;
+		bool needSquare = waves & EvenVCO<T>::SQUARE;
+
+		// Compute frequency, pitch is 1V/oct. The approximation wants a positive argument
+		T freq = dsp::FREQ_C4 * dsp::exp2_taylor5(pitch + 20.0f) / 1048576.0f;
+		freq = simd::clamp(freq, 0.0f, 20000.0f);
+
+		// Pulse width
+		const float minPw = 0.05f;
+		T width = minPw + (simd::clamp(pw, -1.0f, 1.0f) + 1.0f) * (0.5f - minPw);
+
+		// Advance phase
+		T deltaPhase = simd::clamp(freq * delta, 1e-6f, 0.5f);
+		phase += deltaPhase;
+		phase = simd::ifelse(phase >= 1.0f, phase - 1.0f, phase);
+
+		// Tables are read lane by lane
+		for (int i = 0; i < 4; i++) {
+			float p = phase[i];
+
+			if (needSine) {
+				sine[i] = Wavetables::read(tables.sine, p, cubic);
+			}
+
+			if (needDoubleSaw) {
+				float p2 = 2.0f * p;
+				p2 -= (p2 >= 1.0f) ? 1.0f : 0.0f;
+				doubleSaw[i] = Wavetables::read(tables.saw[Wavetables::level(2.0f * deltaPhase[i])], p2, cubic);
+			}
+
+			if (needSaw || needSquare) {
+				const float *table = tables.saw[Wavetables::level(deltaPhase[i])];
+				float s = Wavetables::read(table, p, cubic);
+				saw[i] = s;
+				if (needSquare) {
+					float q = p - width[i];
+					q += (q < 0.0f) ? 1.0f : 0.0f;
+					square[i] = s - Wavetables::read(table, q, cubic) - (2.0f * width[i] - 1.0f);
+				}
+			}
+		}
+
+		if (waves & EvenVCO<T>::EVEN) {
+			even = 0.55f * (doubleSaw + 1.27f * sine);
+		}
+	}
+};
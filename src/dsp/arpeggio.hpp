@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace ah {
+
+namespace arp {
+
+const unsigned int MAX_STEPS = 32; // A round trip over 16 steps is the longest, at 31
+
+/*
+* The walks every pattern and arpeggio is built from, over steps 0 to length - 1. The round trips come back to step 0
+* only when the ends are repeated. REZ and ON_THE_RUN are fixed note tables and ignore the length.
+*/
+enum Shape {
+	RISE,
+	FALL,
+	RISE_FALL,
+	FALL_RISE,
+	REZ,
+	ON_THE_RUN
+};
+
+// How pattern steps become semitones
+enum Scale {
+	SEMITONE,
+	MAJOR,
+	MINOR
+};
+
+constexpr int REZ_NOTES[] = {0, 12, 0, 0, 8, 0, 0, 3, 0, 0, 3, 0, 3, 0, 8, 0};
+constexpr int ON_THE_RUN_NOTES[] = {0, 4, 6, 4, 9, 11, 13, 11};
+
+constexpr int MAJOR_STEPS[7] = {0, 2, 4, 5, 7, 9, 11};
+constexpr int MINOR_STEPS[7] = {0, 2, 3, 5, 7, 8, 10};
+
+// count steps of the scale in semitones, symmetric about 0
+inline int interval(int count, unsigned int scale) {
+	int i = std::abs(count);
+	int sign = (count < 0) ? -1 : (count > 0);
+	switch(scale) {
+		case MAJOR:	return sign * ((i / 7) * 12 + MAJOR_STEPS[i % 7]);
+		case MINOR:	return sign * ((i / 7) * 12 + MINOR_STEPS[i % 7]);
+		default:	return count;
+	}
+}
+
+// A selectable pattern of note offsets. Direction 1 moves away from the root, -1 inverts the walk; note tables
+// are played as written
+struct Pattern {
+	const char *name;
+	Shape shape;
+	int direction;
+};
+
+/*
+* A fixed-capacity run of steps and the position in it, the whole state of one pattern or arpeggio. Building it
+* dispatches once on the shape; stepping is inline on the array.
+*/
+struct Sequence {
+
+	int steps[MAX_STEPS];
+	unsigned int length = 1;
+	unsigned int start = 0;
+	unsigned int index = 0;
+
+	Sequence() {
+		steps[0] = 0;
+	}
+
+	// Arpeggio over nPitches pitches, steps are pitch indexes
+	void initialise(Shape shape, unsigned int nPitches, bool repeatEnd, unsigned int offset = 0) {
+		build(shape, nPitches, repeatEnd);
+		restart(offset);
+	}
+
+	// Pattern of length steps, each step size intervals of the scale from the root, in semitones
+	void initialise(const Pattern &pattern, unsigned int length, unsigned int scale, int size, bool repeatEnd, unsigned int offset = 0) {
+		build(pattern.shape, length, repeatEnd);
+		if (pattern.direction) {
+			for (unsigned int i = 0; i < this->length; i++) {
+				steps[i] = interval(pattern.direction * steps[i] * size, scale);
+			}
+		}
+		restart(offset);
+	}
+
+	void restart(unsigned int offset) {
+		start = offset % length;
+		index = start;
+	}
+
+	void reset() {
+		index = start;
+	}
+
+	void advance() {
+		index++;
+	}
+
+	int get() const {
+		return steps[std::min(index, length - 1)];
+	}
+
+	// On the last step
+	bool isLast() const {
+		return index >= length - 1;
+	}
+
+	// Stepped past the last step
+	bool isFinished() const {
+		return index >= length;
+	}
+
+	// Swap two steps after the start, R provides integer(n) in [0, n)
+	template <typename R>
+	void randomize(R &rng) {
+		int n = length - start;
+		int p1 = rng.integer(n) + start;
+		int p2 = rng.integer(n) + start;
+		int tries = 0;
+
+		while (p1 == p2 && tries < 5) { // Make some effort to change the sequence, break after 5 attempts
+			p2 = rng.integer(n) + start;
+			tries++;
+		}
+
+		std::swap(steps[p1], steps[p2]);
+	}
+
+private:
+
+	void push(int step) {
+		if (length < MAX_STEPS) {
+			steps[length++] = step;
+		}
+	}
+
+	void build(Shape shape, unsigned int n, bool repeatEnd) {
+
+		length = 0;
+		n = std::max(n, 1u);
+		unsigned int end = repeatEnd ? 0 : 1;
+
+		switch(shape) {
+			case RISE:
+				for (unsigned int i = 0; i < n; i++) {
+					push(i);
+				}
+				break;
+			case FALL:
+				for (int i = n - 1; i >= 0; i--) {
+					push(i);
+				}
+				break;
+			case RISE_FALL:
+				for (unsigned int i = 0; i < n; i++) {
+					push(i);
+				}
+				for (int i = n - 2; i >= (int)end; i--) {
+					push(i);
+				}
+				break;
+			case FALL_RISE:
+				for (int i = n - 1; i >= 0; i--) {
+					push(i);
+				}
+				for (unsigned int i = 1; i + end < n; i++) {
+					push(i);
+				}
+				break;
+			case REZ:
+				for (int note : REZ_NOTES) {
+					push(note);
+				}
+				break;
+			case ON_THE_RUN:
+				for (int note : ON_THE_RUN_NOTES) {
+					push(note);
+				}
+				break;
+		}
+
+	}
+
+};
+
+} // namespace arp
+
+} // namespace ah
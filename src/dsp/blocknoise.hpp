@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+
+#include "rack.hpp"
+
+namespace ah {
+
+namespace noise {
+
+const int BLOCK_SIZE = 32; // Frames generated per fill
+
+/*
+* Four independent xoshiro128+ streams, one per float_4 lane. The state is held lane by lane in plain arrays so the
+* update loops vectorise.
+*/
+struct Xoshiro4 {
+
+	uint32_t s0[4];
+	uint32_t s1[4];
+	uint32_t s2[4];
+	uint32_t s3[4];
+
+	Xoshiro4() {
+		seed(nextSeed());
+	}
+
+	// Seeds for generators that are never explicitly seeded come from the constructing thread
+	static uint64_t nextSeed() {
+		static thread_local std::mt19937_64 seeds(std::random_device{}());
+		return seeds();
+	}
+
+	static uint64_t splitmix(uint64_t &x) {
+		uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+
+	void seed(uint64_t seedValue) {
+		for (int i = 0; i < 4; i++) {
+			uint64_t a = splitmix(seedValue);
+			uint64_t b = splitmix(seedValue);
+			s0[i] = (uint32_t)a;
+			s1[i] = (uint32_t)(a >> 32);
+			s2[i] = (uint32_t)b;
+			s3[i] = (uint32_t)(b >> 32);
+		}
+	}
+
+	// Uniform in [-1, 1) on every lane, from the top 24 bits
+	inline void uniform(float *out) {
+		for (int i = 0; i < 4; i++) {
+			uint32_t r = s0[i] + s3[i];
+			uint32_t t = s1[i] << 9;
+			s2[i] ^= s0[i];
+			s3[i] ^= s1[i];
+			s1[i] ^= s2[i];
+			s0[i] ^= s3[i];
+			s2[i] ^= t;
+			s3[i] = (s3[i] << 11) | (s3[i] >> 21);
+			out[i] = (float)(int32_t)(r & 0xFFFFFF00u) * (1.0f / 2147483648.0f);
+		}
+	}
+
+};
+
+/*
+* Base for the block generators. G::fill() writes BLOCK_SIZE frames at a time, next() pops them one by one, so the
+* per-sample cost is a load and there is no virtual dispatch. Lanes are independent streams; monophonic users take
+* lane 0.
+*/
+template <typename G>
+struct BlockNoise {
+
+	alignas(16) float block[BLOCK_SIZE][4];
+	int pos = BLOCK_SIZE;
+	Xoshiro4 rng;
+
+	void seed(uint64_t seedValue) {
+		rng.seed(seedValue);
+		pos = BLOCK_SIZE;
+	}
+
+	inline simd::float_4 next() {
+		if (pos >= BLOCK_SIZE) {
+			static_cast<G *>(this)->fill();
+			pos = 0;
+		}
+		return simd::float_4::load(block[pos++]);
+	}
+
+};
+
+// Uniform in [-1, 1)
+struct WhiteNoise4 : BlockNoise<WhiteNoise4> {
+
+	void fill() {
+		for (int n = 0; n < BLOCK_SIZE; n++) {
+			rng.uniform(block[n]);
+		}
+	}
+
+};
+
+// Voss-McCartney, see http://www.firstpr.com.au/dsp/pink-noise/. Row k is redrawn every 2^(k+1) frames and the
+// rows are summed with a fresh white sample
+struct PinkNoise4 : BlockNoise<PinkNoise4> {
+
+	static const int ROWS = 6;
+
+	float rows[ROWS][4] = {};
+	uint32_t count = 0;
+
+	void fill() {
+		float white[4];
+		for (int n = 0; n < BLOCK_SIZE; n++) {
+			count = (count + 1) & ((1 << ROWS) - 1);
+			if (count) {
+				rng.uniform(rows[__builtin_ctz(count)]);
+			}
+			rng.uniform(white);
+			for (int i = 0; i < 4; i++) {
+				float sum = white[i];
+				for (int k = 0; k < ROWS; k++) {
+					sum += rows[k][i];
+				}
+				block[n][i] = sum * (1.0f / (ROWS + 1));
+			}
+		}
+	}
+
+};
+
+// Leaky integration of white noise; the leak stops it wandering off. Scaled to about the level of PinkNoise4
+struct BrownNoise4 : BlockNoise<BrownNoise4> {
+
+	static constexpr float LEAK = 0.998f;
+	static constexpr float GAIN = 0.022f;
+
+	float state[4] = {};
+
+	void fill() {
+		float white[4];
+		for (int n = 0; n < BLOCK_SIZE; n++) {
+			rng.uniform(white);
+			for (int i = 0; i < 4; i++) {
+				state[i] = state[i] * LEAK + white[i] * GAIN;
+				block[n][i] = state[i];
+			}
+		}
+	}
+
+};
+
+// Standard normal, by Box-Muller on whole lanes; each pair of uniform draws gives two frames
+struct GaussianNoise4 : BlockNoise<GaussianNoise4> {
+
+	void fill() {
+		float a[4];
+		float b[4];
+		for (int n = 0; n < BLOCK_SIZE; n += 2) {
+			rng.uniform(a);
+			rng.uniform(b);
+			simd::float_4 u = 0.5f - 0.5f * simd::float_4::load(a); // (0, 1], keeps the log finite
+			simd::float_4 theta = (float)M_PI * simd::float_4::load(b);
+			simd::float_4 r = simd::sqrt(-2.0f * simd::log(u));
+			(r * simd::cos(theta)).store(block[n]);
+			(r * simd::sin(theta)).store(block[n + 1]);
+		}
+	}
+
+};
+
+} // namespace noise
+
+} // namespace ah